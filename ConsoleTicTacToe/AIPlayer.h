@@ -0,0 +1,95 @@
+#pragma once
+
+#include "GameBoard.h"
+#include "OpeningBook.h"
+
+namespace tictactoe
+{
+	// An abstract computer-controlled player.
+	// SearchMove() may freely Mark() & Unmark() the given board while thinking,
+	// but must return it in the same state it was given.
+	class AIPlayer
+	{
+	public:
+		AIPlayer() : _openingBook(nullptr) {}
+		virtual ~AIPlayer() {}
+
+		// Plays the opening book's move if the position is in it, and otherwise searches for one.
+		BoardPosition ChooseMove(GameBoard& gameBoard, PlayerID playerID)
+		{
+			BoardPosition position;
+			if (_openingBook != nullptr && _openingBook->TryGetMove(gameBoard, &position))
+			{
+				return position;
+			}
+			return SearchMove(gameBoard, playerID);
+		}
+
+		// The book must outlive the player.
+		void SetOpeningBook(const OpeningBook* openingBook) { _openingBook = openingBook; }
+
+	protected:
+		virtual BoardPosition SearchMove(GameBoard& gameBoard, PlayerID playerID) = 0;
+
+		// Boards with more cells than this only consider the frontier (the empty cells near existing markers) as moves.
+		// This makes the search selective rather than exhaustive, so it's kept off the small boards that can be solved.
+		static const uint32_t kMinFrontierSearchCellCount = 100;
+
+		static bool IsFrontierSearch(const GameBoard& gameBoard)
+		{
+			return gameBoard.GetCellCount() > kMinFrontierSearchCellCount &&
+				(gameBoard.GetMarkerCount() == 0 || gameBoard.GetFrontierCellCount() > 0);
+		}
+
+		// The moves to consider, indexed 0 to GetCandidateMoveCount() - 1.
+		// An empty board has no frontier yet, so a frontier search just opens in the center.
+		static uint32_t GetCandidateMoveCount(const GameBoard& gameBoard, bool isFrontierSearch)
+		{
+			if (!isFrontierSearch)
+			{
+				return gameBoard.GetFreeCellCount();
+			}
+			return (gameBoard.GetMarkerCount() == 0) ? 1 : gameBoard.GetFrontierCellCount();
+		}
+
+		static uint32_t GetCandidateMove(const GameBoard& gameBoard, bool isFrontierSearch, uint32_t index)
+		{
+			if (!isFrontierSearch)
+			{
+				return gameBoard.GetFreeCell(index);
+			}
+			if (gameBoard.GetMarkerCount() == 0)
+			{
+				const BoardPosition center = { static_cast<uint16_t>(gameBoard.GetColumns() / 2), static_cast<uint16_t>(gameBoard.GetRows() / 2) };
+				return gameBoard.GetCellIndex(center);
+			}
+			return gameBoard.GetFrontierCell(index);
+		}
+
+		// A uniformly random one of the candidate moves.
+		static uint32_t GetRandomCandidateMove(const GameBoard& gameBoard, bool isFrontierSearch, uint64_t random)
+		{
+			if (!isFrontierSearch)
+			{
+				return gameBoard.GetRandomFreeCell(random);
+			}
+			if (gameBoard.GetMarkerCount() == 0)
+			{
+				return GetCandidateMove(gameBoard, isFrontierSearch, 0);
+			}
+			return gameBoard.GetRandomFrontierCell(random);
+		}
+
+		// xorshift64*; see https://en.wikipedia.org/wiki/Xorshift
+		static uint64_t NextRandom(uint64_t& state)
+		{
+			state ^= state >> 12;
+			state ^= state << 25;
+			state ^= state >> 27;
+			return state * 0x2545F4914F6CDD1Dull;
+		}
+
+	private:
+		const OpeningBook* _openingBook;
+	};
+}
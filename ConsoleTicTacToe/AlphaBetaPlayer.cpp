@@ -0,0 +1,458 @@
+#include "AlphaBetaPlayer.h"
+
+#include "FixedGameBoard.h"
+#include "Tablebase.h"
+
+#include <algorithm>
+#include <cassert>
+#include <cstdlib>
+#include <functional>
+#include <thread>
+
+using namespace tictactoe;
+
+static const int32_t kInfiniteScore = AlphaBetaPlayer::kWinScore + 1;
+static const int32_t kProvenScoreThreshold = AlphaBetaPlayer::kWinScore - UINT16_MAX;
+static const int64_t kMaxHeuristicScore = (1 << 24);
+static const uint64_t kNodesPerTimeCheck = 1024;
+
+static int32_t sScoreToTable(int32_t score, uint16_t ply);
+static int32_t sScoreFromTable(int32_t score, uint16_t ply);
+
+bool AlphaBetaPlayer::IsWinningScore(int32_t score)
+{
+	return score >= kProvenScoreThreshold;
+}
+
+bool AlphaBetaPlayer::IsLosingScore(int32_t score)
+{
+	return score <= -kProvenScoreThreshold;
+}
+
+AlphaBetaPlayer::AlphaBetaPlayer(uint32_t moveTimeMs, uint32_t transpositionTableSizeMB, uint16_t threadCount) :
+	_moveTimeMs(moveTimeMs),
+	_tablebase(nullptr),
+	_transpositionTable(transpositionTableSizeMB),
+	_threads(),
+	_deadline(),
+	_isStopRequested(false),
+	_lastSearchStats()
+{
+	assert(threadCount > 0);
+	_threads.resize(threadCount);
+	for (uint16_t i = 0; i < threadCount; i++)
+	{
+		_threads[i].index = i;
+	}
+}
+
+AlphaBetaPlayer::~AlphaBetaPlayer()
+{
+}
+
+BoardPosition AlphaBetaPlayer::SearchMove(GameBoard& gameBoard, PlayerID playerID)
+{
+	assert(gameBoard.GetNumPlayers() == 2);
+	assert(gameBoard.GetWinningPlayer() == kInvalidPlayerID);
+	assert(!gameBoard.IsFilled());
+
+	const Clock::time_point startTime = Clock::now();
+
+	// A tablebase hit is already solved, and scored the same way as the search scores a proven result.
+	BoardPosition tablebaseMove;
+	TablebaseEntry tablebaseEntry;
+	if (_tablebase != nullptr && _tablebase->ChooseMove(gameBoard, playerID, &tablebaseMove, &tablebaseEntry))
+	{
+		SearchStats stats = {};
+		stats.threadCount = static_cast<uint16_t>(_threads.size());
+		stats.score =
+			(tablebaseEntry.value == TablebaseValue::Win) ? (kWinScore - tablebaseEntry.distance) :
+			(tablebaseEntry.value == TablebaseValue::Loss) ? -(kWinScore - tablebaseEntry.distance) : 0;
+		stats.isSolved = true;
+		stats.elapsedMs = static_cast<uint32_t>(std::chrono::duration_cast<std::chrono::milliseconds>(Clock::now() - startTime).count());
+		_lastSearchStats = stats;
+		return tablebaseMove;
+	}
+
+	_deadline = startTime + std::chrono::milliseconds(_moveTimeMs);
+	_isStopRequested = false;
+
+	// The first thread searches the given board directly; every helper thread searches its own copy.
+	for (SearchThread& thread : _threads)
+	{
+		thread.gameBoardCopy = (thread.index > 0) ? gameBoard.Clone() : nullptr;
+		thread.nodeCount = 0;
+		thread.rootBestMove = TranspositionTable::kNoMove;
+		thread.isAborted = false;
+		thread.bestMove = TranspositionTable::kNoMove;
+		thread.completedDepth = 0;
+		thread.score = 0;
+		thread.isSolved = false;
+	}
+
+	// Dispatching on the board type once here lets the whole search use a FixedGameBoard's non-virtual calls.
+	VisitGameBoard(gameBoard, [this, playerID](auto& board) { SearchInParallel(board, playerID); });
+
+	// Use the result of whichever thread got the furthest.
+	SearchStats stats = {};
+	const SearchThread* bestThread = &_threads[0];
+	for (const SearchThread& thread : _threads)
+	{
+		if ((thread.isSolved && !bestThread->isSolved) ||
+			(thread.isSolved == bestThread->isSolved && thread.completedDepth > bestThread->completedDepth))
+		{
+			bestThread = &thread;
+		}
+		stats.nodeCount += thread.nodeCount;
+	}
+	assert(bestThread->bestMove != TranspositionTable::kNoMove);
+
+	stats.threadCount = static_cast<uint16_t>(_threads.size());
+	stats.completedDepth = bestThread->completedDepth;
+	stats.score = bestThread->score;
+	stats.isSolved = bestThread->isSolved;
+	stats.elapsedMs = static_cast<uint32_t>(std::chrono::duration_cast<std::chrono::milliseconds>(Clock::now() - startTime).count());
+	_lastSearchStats = stats;
+
+	return gameBoard.GetCellPosition(bestThread->bestMove);
+}
+
+template<typename Board>
+void AlphaBetaPlayer::SearchInParallel(Board& gameBoard, PlayerID playerID)
+{
+	std::vector<std::thread> helperThreads;
+	for (size_t i = 1; i < _threads.size(); i++)
+	{
+		helperThreads.emplace_back([this, i, playerID]()
+		{
+			SearchIteratively(_threads[i], static_cast<Board&>(*_threads[i].gameBoardCopy), playerID);
+		});
+	}
+	SearchIteratively(_threads[0], gameBoard, playerID);
+	_isStopRequested = true;
+	for (std::thread& helperThread : helperThreads)
+	{
+		helperThread.join();
+	}
+}
+
+template<typename Board>
+void AlphaBetaPlayer::SearchIteratively(SearchThread& thread, Board& gameBoard, PlayerID playerID)
+{
+	const uint32_t emptyCellCount = gameBoard.GetFreeCellCount();
+	const uint16_t maxDepth = static_cast<uint16_t>(std::min<uint32_t>(emptyCellCount, UINT16_MAX - 1));
+	if (thread.moveLists.size() < static_cast<size_t>(maxDepth) + 1)
+	{
+		thread.moveLists.resize(static_cast<size_t>(maxDepth) + 1);
+	}
+
+	// Every other helper thread starts a ply deeper, so that the threads aren't all working on the same depth.
+	for (uint16_t depth = 1 + (thread.index % 2); depth <= maxDepth; depth++)
+	{
+		const int32_t score = Negamax(thread, gameBoard, playerID, depth, 0, -kInfiniteScore, kInfiniteScore);
+		if (thread.isAborted)
+		{
+			break;
+		}
+
+		thread.bestMove = thread.rootBestMove;
+		thread.completedDepth = depth;
+		thread.score = score;
+
+		// A proven win/loss can't change with more depth, and searching every remaining cell is exhaustive.
+		if (IsWinningScore(score) || IsLosingScore(score) || depth == emptyCellCount)
+		{
+			thread.isSolved = true;
+			_isStopRequested = true;
+			break;
+		}
+	}
+}
+
+template<typename Board>
+int32_t AlphaBetaPlayer::Negamax(SearchThread& thread, Board& gameBoard, PlayerID playerID, uint16_t depth, uint16_t ply, int32_t alpha, int32_t beta)
+{
+	thread.nodeCount++;
+	if (IsStopRequested(thread))
+	{
+		thread.isAborted = true;
+		return 0;
+	}
+
+	const int32_t originalAlpha = alpha;
+
+	// Positions are stored in their canonical orientation so that every reflection / rotation of a position shares
+	// one entry; the stored move is mapped back to this orientation on the way out.
+	const BoardSymmetry symmetry = gameBoard.GetCanonicalSymmetry();
+	const uint64_t key = gameBoard.GetSymmetryHash(symmetry);
+
+	uint32_t tableMove = TranspositionTable::kNoMove;
+	TranspositionTable::Entry entry;
+	if (_transpositionTable.Probe(key, &entry))
+	{
+		if (entry.bestMove != TranspositionTable::kNoMove)
+		{
+			const BoardPosition tablePosition = gameBoard.GetCellPosition(entry.bestMove);
+			tableMove = gameBoard.GetCellIndex(gameBoard.TransformPosition(tablePosition, GameBoard::GetInverseSymmetry(symmetry)));
+		}
+
+		// The root always searches its moves so that a best move is recorded.
+		if (entry.depth >= depth && ply > 0)
+		{
+			const int32_t tableScore = sScoreFromTable(entry.score, ply);
+			switch (entry.bound)
+			{
+				case ScoreBound::Exact:	return tableScore;
+				case ScoreBound::Lower:	alpha = std::max(alpha, tableScore); break;
+				case ScoreBound::Upper:	beta = std::min(beta, tableScore); break;
+				default:				break;
+			}
+			if (alpha >= beta)
+			{
+				return tableScore;
+			}
+		}
+	}
+
+	if (depth == 0)
+	{
+		return Evaluate(gameBoard, playerID);
+	}
+
+	std::vector<uint64_t>& moves = thread.moveLists[ply];
+	GenerateMoves(gameBoard, tableMove, moves);
+
+	const PlayerID nextPlayerID = (playerID + 1) % gameBoard.GetNumPlayers();
+	int32_t bestScore = -kInfiniteScore;
+	uint32_t bestMove = TranspositionTable::kNoMove;
+	for (uint64_t orderedMove : moves)
+	{
+		const uint32_t move = static_cast<uint32_t>(orderedMove);
+		const BoardPosition position = gameBoard.GetCellPosition(move);
+
+		gameBoard.Mark(playerID, position);
+		int32_t score;
+		if (gameBoard.GetWinningPlayer() == playerID)
+		{
+			score = kWinScore - (ply + 1);
+		}
+		else if (gameBoard.IsFilled())
+		{
+			score = 0;
+		}
+		else
+		{
+			score = -Negamax(thread, gameBoard, nextPlayerID, depth - 1, ply + 1, -beta, -alpha);
+		}
+		gameBoard.Unmark(playerID, position);
+
+		if (thread.isAborted)
+		{
+			return 0;
+		}
+
+		if (score > bestScore)
+		{
+			bestScore = score;
+			bestMove = move;
+			if (ply == 0)
+			{
+				thread.rootBestMove = move;
+			}
+		}
+
+		alpha = std::max(alpha, score);
+		if (alpha >= beta)
+		{
+			break;
+		}
+	}
+
+	ScoreBound bound = ScoreBound::Exact;
+	if (bestScore <= originalAlpha)
+	{
+		bound = ScoreBound::Upper;
+	}
+	else if (bestScore >= beta)
+	{
+		bound = ScoreBound::Lower;
+	}
+	uint32_t canonicalMove = TranspositionTable::kNoMove;
+	if (bestMove != TranspositionTable::kNoMove)
+	{
+		canonicalMove = gameBoard.GetCellIndex(gameBoard.TransformPosition(gameBoard.GetCellPosition(bestMove), symmetry));
+	}
+	_transpositionTable.Store(key, sScoreToTable(bestScore, ply), depth, bound, canonicalMove);
+
+	return bestScore;
+}
+
+// Scores every k-length window on the board that only one player has marks in;
+// the more marks in the window, the closer that player is to completing it.
+template<typename Board>
+int32_t AlphaBetaPlayer::Evaluate(const Board& gameBoard, PlayerID playerID) const
+{
+	struct Offset {
+		int16_t x;
+		int16_t y;
+	};
+
+	const Offset offsets[4] =
+	{
+		{  1,  0 },	// '-' - horizontal
+		{  0,  1 },	// '|' - vertical
+		{  1,  1 },	// '\' - backslash
+		{ -1,  1 },	// '/' - forward slash
+	};
+
+	const int32_t columns = gameBoard.GetColumns();
+	const int32_t rows = gameBoard.GetRows();
+	const int32_t length = gameBoard.GetWinCondition();
+
+	int64_t score = 0;
+	for (const Offset& offset : offsets)
+	{
+		for (int32_t y = 0; y < rows; y++)
+		{
+			for (int32_t x = 0; x < columns; x++)
+			{
+				const int32_t endX = x + (offset.x * (length - 1));
+				const int32_t endY = y + (offset.y * (length - 1));
+				if (endX < 0 || endX >= columns || endY >= rows)
+				{
+					continue;
+				}
+
+				uint16_t ownCount = 0;
+				uint16_t otherCount = 0;
+				for (int32_t i = 0; i < length && (ownCount == 0 || otherCount == 0); i++)
+				{
+					const BoardPosition position = {
+						static_cast<uint16_t>(x + (offset.x * i)),
+						static_cast<uint16_t>(y + (offset.y * i)) };
+					const PlayerID marker = gameBoard.GetMarker(position);
+					if (marker == playerID)
+					{
+						ownCount++;
+					}
+					else if (marker != kInvalidPlayerID)
+					{
+						otherCount++;
+					}
+				}
+
+				score += ScoreWindow(ownCount, otherCount);
+			}
+		}
+	}
+
+	return static_cast<int32_t>(std::max(-kMaxHeuristicScore, std::min(score, kMaxHeuristicScore)));
+}
+
+// A FixedGameBoard already has every k-length window as a precomputed line mask, so counting the markers in each
+// is just a couple of masked bit counts.
+template<uint16_t M, uint16_t N, uint16_t K>
+int32_t AlphaBetaPlayer::Evaluate(const FixedGameBoard<M, N, K>& gameBoard, PlayerID playerID) const
+{
+	const PlayerID otherPlayerID = (playerID + 1) % gameBoard.GetNumPlayers();
+
+	int64_t score = 0;
+	for (uint32_t line = 0; line < gameBoard.GetLineCount(); line++)
+	{
+		score += ScoreWindow(gameBoard.CountLineMarkers(line, playerID), gameBoard.CountLineMarkers(line, otherPlayerID));
+	}
+
+	return static_cast<int32_t>(std::max(-kMaxHeuristicScore, std::min(score, kMaxHeuristicScore)));
+}
+
+// The score of a single k-length window, given the number of each player's markers in it.
+int64_t AlphaBetaPlayer::ScoreWindow(uint32_t ownCount, uint32_t otherCount)
+{
+	if (ownCount > 0 && otherCount == 0)
+	{
+		return int64_t(1) << std::min<uint32_t>(2 * ownCount, 20);
+	}
+	else if (otherCount > 0 && ownCount == 0)
+	{
+		return -(int64_t(1) << std::min<uint32_t>(2 * otherCount, 20));
+	}
+	return 0;
+}
+
+// Orders moves by: the transposition table's best move, then the number of adjacent markers,
+// then the distance from the center of the board.
+template<typename Board>
+void AlphaBetaPlayer::GenerateMoves(const Board& gameBoard, uint32_t firstMove, std::vector<uint64_t>& outMoves) const
+{
+	outMoves.clear();
+
+	const int32_t columns = gameBoard.GetColumns();
+	const int32_t rows = gameBoard.GetRows();
+	const bool isFrontierSearch = IsFrontierSearch(gameBoard);
+	const uint32_t moveCount = GetCandidateMoveCount(gameBoard, isFrontierSearch);
+	for (uint32_t i = 0; i < moveCount; i++)
+	{
+		const uint32_t move = GetCandidateMove(gameBoard, isFrontierSearch, i);
+		uint32_t priority = UINT32_MAX;
+		if (move != firstMove)
+		{
+			const BoardPosition position = gameBoard.GetCellPosition(move);
+			const int32_t x = position.x;
+			const int32_t y = position.y;
+
+			uint32_t neighborCount = 0;
+			for (int32_t ny = std::max(y - 1, 0); ny <= std::min(y + 1, rows - 1); ny++)
+			{
+				for (int32_t nx = std::max(x - 1, 0); nx <= std::min(x + 1, columns - 1); nx++)
+				{
+					const BoardPosition neighbor = { static_cast<uint16_t>(nx), static_cast<uint16_t>(ny) };
+					neighborCount += (gameBoard.GetMarker(neighbor) != kInvalidPlayerID) ? 1 : 0;
+				}
+			}
+
+			const uint32_t centerDistance = abs((2 * x) - (columns - 1)) + abs((2 * y) - (rows - 1));
+			priority = (neighborCount << 20) + (0xFFFFF - std::min<uint32_t>(centerDistance, 0xFFFFF));
+		}
+
+		// The cell index in the lower bits keeps the order independent of the free cell list's order.
+		outMoves.push_back((static_cast<uint64_t>(priority) << 32) | move);
+	}
+
+	std::sort(outMoves.begin(), outMoves.end(), std::greater<uint64_t>());
+}
+
+bool AlphaBetaPlayer::IsStopRequested(SearchThread& thread)
+{
+	// Only the first thread watches the clock, and it always finishes its first iteration so there's a move to return.
+	if (thread.index == 0)
+	{
+		if (thread.completedDepth == 0)
+		{
+			return false;
+		}
+
+		if (_moveTimeMs != 0 &&
+			(thread.nodeCount % kNodesPerTimeCheck) == 0 &&
+			Clock::now() >= _deadline)
+		{
+			_isStopRequested = true;
+		}
+	}
+	return _isStopRequested.load(std::memory_order_relaxed);
+}
+
+// Proven win/loss scores are relative to the root; store them relative to the current node instead
+// so they remain valid when the same position is reached at a different ply.
+static int32_t sScoreToTable(int32_t score, uint16_t ply)
+{
+	if (AlphaBetaPlayer::IsWinningScore(score)) return score + ply;
+	if (AlphaBetaPlayer::IsLosingScore(score)) return score - ply;
+	return score;
+}
+
+static int32_t sScoreFromTable(int32_t score, uint16_t ply)
+{
+	if (AlphaBetaPlayer::IsWinningScore(score)) return score - ply;
+	if (AlphaBetaPlayer::IsLosingScore(score)) return score + ply;
+	return score;
+}
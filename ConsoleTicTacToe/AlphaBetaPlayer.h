@@ -0,0 +1,96 @@
+#pragma once
+
+#include "AIPlayer.h"
+#include "TranspositionTable.h"
+
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <vector>
+
+namespace tictactoe
+{
+	template<uint16_t M, uint16_t N, uint16_t K> class FixedGameBoard;
+	class Tablebase;
+
+	// A computer player that searches the game tree with negamax alpha-beta pruning.
+	// The search is iteratively deepened until the position is solved or the per-move time budget runs out,
+	// and results are cached in a TranspositionTable that persists between moves.
+	// See https://en.wikipedia.org/wiki/Negamax
+	//
+	// With more than one thread the search uses 'Lazy SMP': every helper thread searches the same root on its own
+	// copy of the board, and the threads only cooperate through the shared (lock-free) TranspositionTable.
+	class AlphaBetaPlayer : public AIPlayer
+	{
+	public:
+		struct SearchStats
+		{
+			uint64_t nodeCount;
+			uint16_t threadCount;
+			uint16_t completedDepth;
+			int32_t score;
+			uint32_t elapsedMs;
+			bool isSolved;
+		};
+
+		static const int32_t kWinScore = (1 << 30);
+
+		static bool IsWinningScore(int32_t score);
+		static bool IsLosingScore(int32_t score);
+
+		// A moveTimeMs of 0 searches without a time limit (until the position is solved).
+		AlphaBetaPlayer(uint32_t moveTimeMs, uint32_t transpositionTableSizeMB, uint16_t threadCount);
+		virtual ~AlphaBetaPlayer();
+
+		const SearchStats& GetLastSearchStats() const { return _lastSearchStats; }
+
+		// Positions found in the tablebase are played from it without searching. The tablebase must outlive the player.
+		void SetTablebase(const Tablebase* tablebase) { _tablebase = tablebase; }
+
+	protected:
+		virtual BoardPosition SearchMove(GameBoard& gameBoard, PlayerID playerID) override;
+
+	private:
+		typedef std::chrono::steady_clock Clock;
+
+		// The state owned by each searching thread.
+		struct SearchThread
+		{
+			uint16_t index;
+			std::unique_ptr<GameBoard> gameBoardCopy;	// Unused by the first thread, which searches the given board.
+
+			// One list per ply so move generation doesn't allocate during the search.
+			// Each entry holds a move's ordering priority in the upper 32 bits and its cell index in the lower 32 bits.
+			std::vector<std::vector<uint64_t>> moveLists;
+
+			uint64_t nodeCount;
+			uint32_t rootBestMove;
+			bool isAborted;
+
+			uint32_t bestMove;
+			uint16_t completedDepth;
+			int32_t score;
+			bool isSolved;
+		};
+
+		// The search is templated on the board type (GameBoard or a FixedGameBoard); see VisitGameBoard().
+		template<typename Board> void SearchInParallel(Board& gameBoard, PlayerID playerID);
+		template<typename Board> void SearchIteratively(SearchThread& thread, Board& gameBoard, PlayerID playerID);
+		template<typename Board> int32_t Negamax(SearchThread& thread, Board& gameBoard, PlayerID playerID, uint16_t depth, uint16_t ply, int32_t alpha, int32_t beta);
+		template<typename Board> int32_t Evaluate(const Board& gameBoard, PlayerID playerID) const;
+		template<uint16_t M, uint16_t N, uint16_t K> int32_t Evaluate(const FixedGameBoard<M, N, K>& gameBoard, PlayerID playerID) const;
+		static int64_t ScoreWindow(uint32_t ownCount, uint32_t otherCount);
+		template<typename Board> void GenerateMoves(const Board& gameBoard, uint32_t firstMove, std::vector<uint64_t>& outMoves) const;
+		bool IsStopRequested(SearchThread& thread);
+
+		uint32_t _moveTimeMs;
+		const Tablebase* _tablebase;
+		TranspositionTable _transpositionTable;
+		std::vector<SearchThread> _threads;
+
+		Clock::time_point _deadline;
+		std::atomic<bool> _isStopRequested;
+
+		SearchStats _lastSearchStats;
+	};
+}
@@ -1,5 +1,6 @@
 #include "BasicGame.h"
 
+#include <cassert>
 #include <iomanip>
 #include <iostream>
 #include <string>
@@ -7,6 +8,8 @@
 using namespace tictactoe;
 
 static bool sTryParseUInt(const std::string& str, uint16_t* outValue);
+static bool sTryParseUInt(const std::string& str, uint64_t* outValue);
+
 std::ostream& operator<<(std::ostream& os, const BoardPosition& position);
 std::ostream& operator<<(std::ostream& os, const GameBoard& gameBoard);
 
@@ -30,6 +33,12 @@ bool BasicGame::Update()
 {
 	ExecuteStatusCommand();
 
+	if (GetGameStatus() == GameStatus::Active &&
+		IsAIPlayer(GetActivePlayer()))
+	{
+		return ExecuteAIMove();
+	}
+
 	bool isTurnOver = false;
 	while (!isTurnOver)
 	{
@@ -43,7 +52,12 @@ bool BasicGame::Update()
 		std::cout << "Enter a command: ";
 
 		std::string inputCommand;
-		std::getline(std::cin, inputCommand);
+		if (!std::getline(std::cin, inputCommand))
+		{
+			// The input was closed or interrupted, so no more commands are coming.
+			std::cout << std::endl;
+			return false;
+		}
 
 		auto commandNameEnd = inputCommand.find(' ');
 		if (inputCommand.compare(0, commandNameEnd, "mark") == 0)
@@ -58,6 +72,10 @@ bool BasicGame::Update()
 		{
 			isTurnOver = ExecuteRedoCommand();
 		}
+		else if (inputCommand.compare(0, commandNameEnd, "seek") == 0)
+		{
+			isTurnOver = ExecuteSeekCommand(inputCommand.substr(commandNameEnd + 1));
+		}
 		else if (inputCommand.compare(0, commandNameEnd, "help") == 0)
 		{
 			ExecuteHelpCommand();
@@ -110,6 +128,23 @@ void BasicGame::ApplyRedo(const PlayerMove& move)
 		<< std::endl;
 }
 
+bool BasicGame::ExecuteAIMove()
+{
+	std::cout
+		<< "[" << GetPlayerName(GetActivePlayer())
+		<< " (" << GetPlayerChar(GetActivePlayer()) << ")"
+		<< "] Thinking..."
+		<< std::endl;
+
+	BoardPosition position;
+	auto result = MarkAIMove(&position);
+	assert(result == MarkResult::Success);
+	(void)result;
+	std::cout << "Marker placed at " << position << std::endl;
+
+	return true;
+}
+
 bool BasicGame::ExecuteMarkCommand(std::string params)
 {
 	bool result = false;
@@ -161,7 +196,7 @@ bool BasicGame::ExecuteMarkCommand(std::string params)
 
 bool BasicGame::ExecuteUndoCommand()
 {
-	bool result = Undo();
+	bool result = UndoTurn();
 	if (!result)
 	{
 		std::cerr << "Error: Unable to perform undo." << std::endl;
@@ -171,7 +206,7 @@ bool BasicGame::ExecuteUndoCommand()
 
 bool BasicGame::ExecuteRedoCommand()
 {
-	bool result = Redo();
+	bool result = RedoTurn();
 	if (!result)
 	{
 		std::cerr << "Error: Unable to perform redo." << std::endl;
@@ -179,6 +214,31 @@ bool BasicGame::ExecuteRedoCommand()
 	return result;
 }
 
+bool BasicGame::ExecuteSeekCommand(std::string params)
+{
+	bool result = false;
+
+	uint64_t moveIndex;
+	if (sTryParseUInt(params, &moveIndex))
+	{
+		result = SeekTo(moveIndex);
+		if (result)
+		{
+			std::cout << "Moved to move " << moveIndex << "." << std::endl;
+		}
+		else
+		{
+			std::cerr << "Error: There is no move " << moveIndex << " in the current line." << std::endl;
+		}
+	}
+	else
+	{
+		std::cerr << "Error: Invalid input for 'seek <n>' command." << std::endl;
+	}
+
+	return result;
+}
+
 bool BasicGame::ExecuteHelpCommand()
 {
 	auto printCmd = [](const char* cmd, const char* desc)
@@ -199,6 +259,10 @@ bool BasicGame::ExecuteHelpCommand()
 	{
 		printCmd("redo", "Moves forward a turn, re-placing a reverted marker placement.");
 	}
+	if (GetMoveHistory().GetAvailableUndosCount() > 0 || GetMoveHistory().GetAvailableRedosCount() > 0)
+	{
+		printCmd("seek <n>", "Moves to the board after the first <n> moves, undoing or redoing the rest.");
+	}
 	printCmd("help",			"Prints this help message.");
 	printCmd("status",			"Prints the current state of the game.");
 	printCmd("reset",			"Clears the current game board and restarts the game.");
@@ -257,17 +321,36 @@ bool BasicGame::ExecuteQuitCommand()
 }
 
 static bool sTryParseUInt(const std::string& str, uint16_t* outValue)
+{
+	uint64_t value;
+	*outValue = 0;
+	if (!sTryParseUInt(str, &value) || value >= UINT16_MAX)
+	{
+		return false;
+	}
+
+	*outValue = static_cast<uint16_t>(value);
+	return true;
+}
+
+static bool sTryParseUInt(const std::string& str, uint64_t* outValue)
 {
 	bool result = false;
 	*outValue = 0;
 
+	// std::stoull skips leading whitespace and wraps a negative value around, so anything but a digit is rejected.
+	if (str.empty() || str[0] < '0' || str[0] > '9')
+	{
+		return false;
+	}
+
 	try
 	{
 		size_t pos;
-		auto value = std::stoul(str, &pos);
-		if (value < UINT16_MAX && pos == str.length())
+		auto value = std::stoull(str, &pos);
+		if (pos == str.length())
 		{
-			*outValue = static_cast<uint16_t>(value);
+			*outValue = static_cast<uint64_t>(value);
 			result = true;
 		}
 	}
@@ -21,9 +21,11 @@ namespace tictactoe
 		virtual void ApplyRedo(const PlayerMove& move) override;
 
 	private:
+		bool ExecuteAIMove();
 		bool ExecuteMarkCommand(std::string params);
 		bool ExecuteUndoCommand();
 		bool ExecuteRedoCommand();
+		bool ExecuteSeekCommand(std::string params);
 		bool ExecuteHelpCommand();
 		bool ExecuteStatusCommand();
 		bool ExecuteResetCommand();
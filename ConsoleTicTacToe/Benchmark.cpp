@@ -0,0 +1,132 @@
+#include "Benchmark.h"
+
+#include "AlphaBetaPlayer.h"
+#include "FixedGameBoard.h"
+#include "GameSimulation.h"
+#include "MCTSPlayer.h"
+
+#include <chrono>
+#include <functional>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <vector>
+
+using namespace tictactoe;
+
+static const uint16_t kBenchmarkMoveCount = 8;
+static const uint32_t kBenchmarkTranspositionTableSizeMB = 64;
+static const uint32_t kBenchmarkNodePoolSizeMB = 256;
+
+// Creates a player with the given thread count, and returns the work it did (nodes, playouts, ...) for its last move.
+typedef std::function<std::unique_ptr<AIPlayer>(uint16_t threadCount)> PlayerFactory;
+typedef std::function<uint64_t(const AIPlayer& player)> WorkCounter;
+
+static void sRunBenchmark(
+	const char* benchmarkName, const char* workName,
+	uint16_t m, uint16_t n, uint16_t k, uint16_t maxThreadCount, uint32_t moveTimeMs,
+	const PlayerFactory& createPlayer, const WorkCounter& getWorkCount);
+
+void tictactoe::RunSearchBenchmark(uint16_t m, uint16_t n, uint16_t k, uint16_t maxThreadCount, uint32_t moveTimeMs)
+{
+	sRunBenchmark(
+		"Search", "nodes",
+		m, n, k, maxThreadCount, moveTimeMs,
+		[moveTimeMs](uint16_t threadCount)
+		{
+			return std::make_unique<AlphaBetaPlayer>(moveTimeMs, kBenchmarkTranspositionTableSizeMB, threadCount);
+		},
+		[](const AIPlayer& player)
+		{
+			return static_cast<const AlphaBetaPlayer&>(player).GetLastSearchStats().nodeCount;
+		});
+}
+
+void tictactoe::RunPlayoutBenchmark(uint16_t m, uint16_t n, uint16_t k, uint16_t maxThreadCount, uint32_t moveTimeMs)
+{
+	sRunBenchmark(
+		"Playout", "playouts",
+		m, n, k, maxThreadCount, moveTimeMs,
+		[moveTimeMs](uint16_t threadCount)
+		{
+			return std::make_unique<MCTSPlayer>(0, moveTimeMs, kBenchmarkNodePoolSizeMB, threadCount);
+		},
+		[](const AIPlayer& player)
+		{
+			return static_cast<const MCTSPlayer&>(player).GetLastSearchStats().playoutCount;
+		});
+}
+
+static void sRunBenchmark(
+	const char* benchmarkName, const char* workName,
+	uint16_t m, uint16_t n, uint16_t k, uint16_t maxThreadCount, uint32_t moveTimeMs,
+	const PlayerFactory& createPlayer, const WorkCounter& getWorkCount)
+{
+	const std::string perSecondName = std::string(workName) + "/s";
+	const std::string perThreadName = perSecondName + "/thread";
+
+	std::vector<uint16_t> threadCounts;
+	for (uint16_t threadCount = 1; threadCount < maxThreadCount; threadCount *= 2)
+	{
+		threadCounts.push_back(threadCount);
+	}
+	threadCounts.push_back(maxThreadCount);
+
+	std::cout << benchmarkName << " benchmark: " << m << "x" << n << ", " << k << "-in-a-row, ";
+	std::cout << kBenchmarkMoveCount << " moves at " << moveTimeMs << " ms each" << std::endl;
+	std::cout
+		<< std::right
+		<< std::setw(8) << "threads"
+		<< std::setw(14) << workName
+		<< std::setw(10) << "seconds"
+		<< std::setw(14) << perSecondName
+		<< std::setw(20) << perThreadName
+		<< std::setw(10) << "speedup"
+		<< std::endl;
+
+	double baseWorkPerSecond = 0.0;
+	for (uint16_t threadCount : threadCounts)
+	{
+		std::unique_ptr<AIPlayer> player = createPlayer(threadCount);
+		std::unique_ptr<GameBoard> gameBoard = CreateGameBoard(m, n, k, GameSimulation::kNumPlayers);
+
+		uint64_t workCount = 0;
+		std::chrono::steady_clock::duration elapsedTime(0);
+		PlayerID playerID = 0;
+		for (uint16_t move = 0; move < kBenchmarkMoveCount; move++)
+		{
+			if (gameBoard->GetWinningPlayer() != kInvalidPlayerID || gameBoard->IsFilled())
+			{
+				break;
+			}
+
+			const auto startTime = std::chrono::steady_clock::now();
+			const BoardPosition position = player->ChooseMove(*gameBoard, playerID);
+			workCount += getWorkCount(*player);
+			elapsedTime += std::chrono::steady_clock::now() - startTime;
+
+			gameBoard->Mark(playerID, position);
+			playerID = (playerID + 1) % GameSimulation::kNumPlayers;
+		}
+
+		const double seconds = std::chrono::duration<double>(elapsedTime).count();
+		const double workPerSecond = (seconds > 0.0) ? (workCount / seconds) : 0.0;
+		if (baseWorkPerSecond == 0.0)
+		{
+			baseWorkPerSecond = workPerSecond;
+		}
+
+		std::cout
+			<< std::fixed << std::setprecision(4)
+			<< std::setw(8) << threadCount
+			<< std::setw(14) << workCount
+			<< std::setw(10) << seconds
+			<< std::setprecision(0)
+			<< std::setw(14) << workPerSecond
+			<< std::setw(20) << (workPerSecond / threadCount)
+			<< std::setprecision(2)
+			<< std::setw(9) << ((baseWorkPerSecond > 0.0) ? (workPerSecond / baseWorkPerSecond) : 0.0) << "x"
+			<< std::endl;
+	}
+}
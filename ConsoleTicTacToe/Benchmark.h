@@ -0,0 +1,14 @@
+#pragma once
+
+#include <cstdint>
+
+namespace tictactoe
+{
+	// Measures AlphaBetaPlayer search throughput on an empty m,n,k board with 1, 2, 4, ... up to maxThreadCount threads.
+	// Each run plays the opening moves of a game with the given time per move, then prints the total nodes per second
+	// and nodes per second per thread for that thread count.
+	void RunSearchBenchmark(uint16_t m, uint16_t n, uint16_t k, uint16_t maxThreadCount, uint32_t moveTimeMs);
+
+	// The MCTSPlayer equivalent of RunSearchBenchmark(), which measures playouts per second instead.
+	void RunPlayoutBenchmark(uint16_t m, uint16_t n, uint16_t k, uint16_t maxThreadCount, uint32_t moveTimeMs);
+}
@@ -0,0 +1,189 @@
+#include "BitBoard.h"
+
+#include <algorithm>
+#include <cassert>
+
+using namespace tictactoe;
+
+static BitBoard::Word sGetShiftedWord(const BitBoard::Word* row, int32_t wordIndex, int32_t shift, uint16_t wordsPerRow);
+static bool sAnyBitInRange(const BitBoard::Word* row, int32_t firstBit, int32_t lastBit);
+
+BitBoard::BitBoard(uint16_t columns, uint16_t rows) :
+	_columns(columns),
+	_rows(rows),
+	_wordsPerRow(static_cast<uint16_t>((columns + kBitsPerWord - 1) / kBitsPerWord)),
+	_generation(1),
+	_rowGenerations(rows, 0),
+	_words(),
+	_emptyRow(_wordsPerRow, 0),
+	_scratch()
+{
+	_words.resize(static_cast<size_t>(_wordsPerRow) * _rows, 0);
+}
+
+void BitBoard::Set(uint16_t x, uint16_t y)
+{
+	assert(x < _columns && y < _rows);
+	GetWritableRow(y)[x / kBitsPerWord] |= (Word(1) << (x % kBitsPerWord));
+}
+
+void BitBoard::Reset(uint16_t x, uint16_t y)
+{
+	assert(x < _columns && y < _rows);
+	GetWritableRow(y)[x / kBitsPerWord] &= ~(Word(1) << (x % kBitsPerWord));
+}
+
+bool BitBoard::Test(uint16_t x, uint16_t y) const
+{
+	assert(x < _columns && y < _rows);
+	return (GetRow(y)[x / kBitsPerWord] >> (x % kBitsPerWord)) & 1;
+}
+
+void BitBoard::Clear()
+{
+	_generation++;
+	if (_generation == 0)
+	{
+		std::fill(_rowGenerations.begin(), _rowGenerations.end(), 0);
+		_generation = 1;
+	}
+}
+
+const BitBoard::Word* BitBoard::GetRow(uint16_t y) const
+{
+	return (_rowGenerations[y] == _generation) ? &_words[y * _wordsPerRow] : &_emptyRow[0];
+}
+
+BitBoard::Word* BitBoard::GetWritableRow(uint16_t y)
+{
+	Word* row = &_words[y * _wordsPerRow];
+	if (_rowGenerations[y] != _generation)
+	{
+		std::fill(row, row + _wordsPerRow, 0);
+		_rowGenerations[y] = _generation;
+	}
+	return row;
+}
+
+bool BitBoard::HasRunThrough(uint16_t x, uint16_t y, int16_t xStep, int16_t yStep, uint16_t length) const
+{
+	assert(yStep == 0 || yStep == 1);
+	assert(length > 0);
+
+	if (!Test(x, y))
+	{
+		return false;
+	}
+
+	// Horizontal lines are always scanned left-to-right; this keeps the in-place shifts below from aliasing.
+	if (yStep == 0)
+	{
+		xStep = 1;
+	}
+
+	// Only the band of rows that a run through (x, y) could touch needs to be considered.
+	const int32_t rowSpan = (length - 1) * yStep;
+	const int32_t bandTop = std::max<int32_t>(0, y - rowSpan);
+	const int32_t bandBottom = std::min<int32_t>(_rows - 1, y + rowSpan);
+	int32_t bandRows = bandBottom - bandTop + 1;
+	if (bandRows <= rowSpan)
+	{
+		return false;
+	}
+
+	_scratch.resize(bandRows * _wordsPerRow);
+	for (int32_t r = 0; r < bandRows; r++)
+	{
+		const Word* row = GetRow(static_cast<uint16_t>(bandTop + r));
+		std::copy(row, row + _wordsPerRow, &_scratch[r * _wordsPerRow]);
+	}
+
+	// Combines each band row with the (shifted) row 'offset' steps further along the line. After combining
+	// with offsets 1, 2, 4, ... bit c of band row r is set only if the whole run starting at (c, r) is set.
+	auto combine = [&](int32_t offset)
+	{
+		const int32_t rowOffset = offset * yStep;
+		const int32_t shift = offset * xStep;
+		bandRows -= rowOffset;
+		for (int32_t r = 0; r < bandRows; r++)
+		{
+			Word* dst = &_scratch[r * _wordsPerRow];
+			const Word* src = &_scratch[(r + rowOffset) * _wordsPerRow];
+			for (int32_t w = 0; w < _wordsPerRow; w++)
+			{
+				dst[w] &= sGetShiftedWord(src, w, shift, _wordsPerRow);
+			}
+		}
+	};
+
+	int32_t runLength = 1;
+	while (runLength * 2 <= length)
+	{
+		combine(runLength);
+		runLength *= 2;
+	}
+	if (runLength < length)
+	{
+		// The two overlapping windows of runLength (>= length / 2) cover the full run.
+		combine(length - runLength);
+	}
+
+	if (yStep == 0)
+	{
+		return sAnyBitInRange(&_scratch[0], std::max<int32_t>(0, x - (length - 1)), x);
+	}
+
+	// Check each run start whose line passes through (x, y).
+	for (int32_t startY = std::max<int32_t>(bandTop, y - (length - 1)); startY <= y; startY++)
+	{
+		const int32_t r = startY - bandTop;
+		const int32_t startX = x - ((y - startY) * xStep);
+		if (r < bandRows && startX >= 0 && startX < _columns &&
+			sAnyBitInRange(&_scratch[r * _wordsPerRow], startX, startX))
+		{
+			return true;
+		}
+	}
+	return false;
+}
+
+// Returns word 'wordIndex' of the row shifted such that bit c of the result is bit (c + shift) of the row.
+static BitBoard::Word sGetShiftedWord(const BitBoard::Word* row, int32_t wordIndex, int32_t shift, uint16_t wordsPerRow)
+{
+	const int32_t bits = BitBoard::kBitsPerWord;
+	auto getWord = [=](int32_t index) -> BitBoard::Word
+	{
+		return (index >= 0 && index < wordsPerRow) ? row[index] : 0;
+	};
+
+	if (shift >= 0)
+	{
+		const int32_t wordShift = shift / bits;
+		const int32_t bitShift = shift % bits;
+		const BitBoard::Word lo = getWord(wordIndex + wordShift);
+		return (bitShift == 0) ? lo : (lo >> bitShift) | (getWord(wordIndex + wordShift + 1) << (bits - bitShift));
+	}
+	else
+	{
+		const int32_t wordShift = -shift / bits;
+		const int32_t bitShift = -shift % bits;
+		const BitBoard::Word hi = getWord(wordIndex - wordShift);
+		return (bitShift == 0) ? hi : (hi << bitShift) | (getWord(wordIndex - wordShift - 1) >> (bits - bitShift));
+	}
+}
+
+static bool sAnyBitInRange(const BitBoard::Word* row, int32_t firstBit, int32_t lastBit)
+{
+	const int32_t bits = BitBoard::kBitsPerWord;
+	for (int32_t w = firstBit / bits; w <= lastBit / bits; w++)
+	{
+		const int32_t lo = std::max(firstBit - (w * bits), 0);
+		const int32_t hi = std::min(lastBit - (w * bits), bits - 1);
+		const BitBoard::Word mask = (~BitBoard::Word(0) >> (bits - 1 - hi)) & (~BitBoard::Word(0) << lo);
+		if (row[w] & mask)
+		{
+			return true;
+		}
+	}
+	return false;
+}
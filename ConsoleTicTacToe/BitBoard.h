@@ -0,0 +1,47 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+namespace tictactoe
+{
+	// A single player's markers stored as one bit per cell.
+	// Every row is padded to a whole number of 64-bit words (so boards wider than 64 columns use multi-word rows),
+	// which allows runs in any of the four board directions to be found with word-wide shifts & ANDs
+	// rather than by stepping from cell to cell.
+	class BitBoard
+	{
+	public:
+		typedef uint64_t Word;
+		static const uint16_t kBitsPerWord = 64;
+
+		BitBoard(uint16_t columns, uint16_t rows);
+
+		void Set(uint16_t x, uint16_t y);
+		void Reset(uint16_t x, uint16_t y);
+		bool Test(uint16_t x, uint16_t y) const;
+		void Clear();
+
+		// Returns true if there are at least 'length' consecutive set bits along the (xStep, yStep) direction
+		// that include the cell at (x, y). yStep must be 0 or 1 (the opposite direction describes the same line).
+		bool HasRunThrough(uint16_t x, uint16_t y, int16_t xStep, int16_t yStep, uint16_t length) const;
+
+		uint16_t GetWordsPerRow() const { return _wordsPerRow; }
+		const Word* GetRow(uint16_t y) const;
+
+	private:
+		Word* GetWritableRow(uint16_t y);
+
+		uint16_t _columns;
+		uint16_t _rows;
+		uint16_t _wordsPerRow;
+
+		// Rows are stamped with the generation they were last written in; rows from an older generation
+		// read as empty, so Clear() only needs to advance the generation.
+		uint16_t _generation;
+		std::vector<uint16_t> _rowGenerations;
+		std::vector<Word> _words;
+		std::vector<Word> _emptyRow;
+		mutable std::vector<Word> _scratch;
+	};
+}
@@ -1,15 +1,41 @@
 #include "ConsoleInterface.h"
 
+#include <algorithm>
 #include <cassert>
 #include <cstdio>
+#include <cstdlib>
+#include <cstring>
 #include <utility>
 
+#ifndef _WIN32
+#include <cerrno>
+#include <csignal>
+
+#include <sys/ioctl.h>
+#include <unistd.h>
+#endif
+
 using namespace tictactoe;
 
 static const ConsoleSize kAbsoluteMinimumBufferSize = { 1, 1 };
+static const uint8_t kClearAttributes = 0;
+
+// A character that no draw call writes, marking the transparent cells of a sprite as it's rasterized.
+static const char kTransparentChar = '\0';
+
+static uint8_t sConsoleColorsToAttributes(const ConsoleColor& foregroundColor, const ConsoleColor& backgroundColor);
+
+#ifdef _WIN32
+
+static_assert(
+	static_cast<WORD>(ConsoleColor::DarkBlue) == FOREGROUND_BLUE && static_cast<WORD>(ConsoleColor::DarkGreen) == FOREGROUND_GREEN &&
+	static_cast<WORD>(ConsoleColor::DarkRed) == FOREGROUND_RED && static_cast<WORD>(ConsoleColor::LightGray) == FOREGROUND_INTENSITY,
+	"ConsoleColor must match the console's attribute bits.");
+
 static const SMALL_RECT kAbsoluteMinimumWindowSmallRect = { 0, 0, 1, 1 };
 
-static WORD sConsoleColorsToAttributes(const ConsoleColor& foregroundColor, const ConsoleColor& backgroundColor);
+// WriteConsoleOutput() fails for buffers over 64KB on some versions of Windows, so larger regions are split.
+static const uint32_t kMaxRegionCellCount = 8192;
 
 static COORD sConsoleSizeToCoord(const ConsoleSize& size);
 static ConsoleSize sCoordToConsoleSize(const COORD& coord);
@@ -17,20 +43,142 @@ static ConsoleSize sCoordToConsoleSize(const COORD& coord);
 static SMALL_RECT sConsoleRectToSmallRect(const ConsoleRect& rect);
 static ConsoleRect sSmallRectToConsoleRect(const SMALL_RECT& rect);
 
+#else
+
+// Switches to the alternate screen (so the terminal's contents come back afterwards), hides the cursor and turns on
+// reporting of every mouse event in the SGR format; and undoes all of that.
+static const char kEnterSequence[] = "\x1b[?1049h\x1b[?25l\x1b[?1003h\x1b[?1006h";
+static const char kLeaveSequence[] = "\x1b[?1006l\x1b[?1003l\x1b[0m\x1b[?25h\x1b[?1049l";
+
+// Terminals don't report double clicks, so two presses this close together on the same cell make one.
+static const std::chrono::milliseconds kDoubleClickTime(500);
+
+// An escape sequence may be split across reads, so an escape with nothing after it is only taken to be the Escape key
+// once this long has passed without any more input.
+static const std::chrono::milliseconds kEscapeKeyTime(100);
+
+// Rewriting up to this many unchanged cells is shorter than moving the cursor past them.
+static const uint16_t kMaxRewrittenCellCount = 8;
+
+// The Win32 virtual key codes for the keys that aren't characters.
+static const uint16_t kConsoleKeyBack = 0x08;
+static const uint16_t kConsoleKeyTab = 0x09;
+static const uint16_t kConsoleKeyReturn = 0x0D;
+
+static volatile sig_atomic_t sgIsResizePending = 0;
+static volatile sig_atomic_t sgIsLeaveSequencePending = 0;
+static void sOnResizeSignal(int signal);
+
+static ConsoleSize sGetTerminalSize();
+static void sWriteAll(const char* data, size_t size);
+static void sAppendNumber(std::string& str, uint32_t value);
+
+#endif
+
 ConsoleSize ConsoleRect::GetSize() const
 {
-	auto width = max(right - left, 0) + 1;
-	auto height = max(bottom - top, 0) + 1;
+	auto width = std::max(right - left, 0) + 1;
+	auto height = std::max(bottom - top, 0) + 1;
 	return { static_cast<uint16_t>(width), static_cast<uint16_t>(height) };
 }
 
+void ConsoleInterface::SetCallbacks(KeyEventCallback keyCb, MouseEventCallback mouseCb, ResizeEventCallback resizeCb)
+{
+	_keyEventCallback = std::move(keyCb);
+	_mouseEventCallback = std::move(mouseCb);
+	_resizeEventCallback = std::move(resizeCb);
+}
+
+void ConsoleInterface::SetMinBufferSize(const ConsoleSize& size)
+{
+	_minBufferSize.width = std::max(size.width, kAbsoluteMinimumBufferSize.width);
+	_minBufferSize.height = std::max(size.height, kAbsoluteMinimumBufferSize.height);
+
+	uint16_t w = std::max(_currentBufferSize.width, _minBufferSize.width);
+	uint16_t h = std::max(_currentBufferSize.height, _minBufferSize.height);
+	if (w != _currentBufferSize.width ||
+		h != _currentBufferSize.height)
+	{
+		ResizeBuffer(w, h);
+	}
+}
+
+void ConsoleInterface::ResizeBackBuffer(uint16_t w, uint16_t h)
+{
+	// Keep what's been drawn, like resizing a console screen buffer does.
+	std::vector<Cell> backBuffer(static_cast<size_t>(w) * h, { ' ', kClearAttributes });
+	const uint16_t copyWidth = std::min(w, _currentBufferSize.width);
+	const uint16_t copyHeight = std::min(h, _currentBufferSize.height);
+	for (uint16_t y = 0; y < copyHeight; y++)
+	{
+		std::copy_n(&_backBuffer[y * _currentBufferSize.width], copyWidth, &backBuffer[y * w]);
+	}
+
+	_backBuffer.swap(backBuffer);
+	_frontBuffer.assign(_backBuffer.size(), { ' ', kClearAttributes });
+	_dirtyRows.assign(h, 1);
+	_currentBufferSize = { w, h };
+
+	// Whatever the screen holds now, the next Present() rewrites all of it.
+	_isBackBufferDirty = true;
+	_isFrontBufferValid = false;
+}
+
+// Finds the first & last cells of row y that differ from the screen. Returns false if none do.
+bool ConsoleInterface::FindChangedSpan(uint16_t y, uint16_t* outLeft, uint16_t* outRight) const
+{
+	const uint16_t width = _currentBufferSize.width;
+	if (!_isFrontBufferValid)
+	{
+		*outLeft = 0;
+		*outRight = width - 1;
+		return true;
+	}
+
+	// Rows that haven't been drawn on can't have changed, so only those that have are compared.
+	if (!_dirtyRows[y])
+	{
+		return false;
+	}
+
+	const Cell* back = &_backBuffer[y * width];
+	const Cell* front = &_frontBuffer[y * width];
+	if (memcmp(back, front, width * sizeof(Cell)) == 0)
+	{
+		return false;
+	}
+
+	uint16_t left = 0;
+	while (back[left] == front[left])
+	{
+		left++;
+	}
+	uint16_t right = width - 1;
+	while (back[right] == front[right])
+	{
+		right--;
+	}
+
+	*outLeft = left;
+	*outRight = right;
+	return true;
+}
+
+#ifdef _WIN32
+
 ConsoleInterface::ConsoleInterface() :
 	_stdInHandle(GetStdHandle(STD_INPUT_HANDLE)),
 	_stdOutHandle(GetStdHandle(STD_OUTPUT_HANDLE)),
 	_cachedInfo(),
+	_region(),
 	_keyEventCallback(nullptr),
 	_mouseEventCallback(nullptr),
 	_resizeEventCallback(nullptr),
+	_backBuffer(),
+	_frontBuffer(),
+	_dirtyRows(),
+	_isBackBufferDirty(true),
+	_isFrontBufferValid(false),
 	_minBufferSize(kAbsoluteMinimumBufferSize),
 	_currentBufferSize(),
 	_currentBufferViewportRect()
@@ -72,13 +220,15 @@ ConsoleInterface::ConsoleInterface() :
 	result = SetConsoleWindowInfo(_stdOutHandle, true, &windowInfo);
 	assert(result);
 
-	_currentBufferSize = sCoordToConsoleSize(_cachedInfo.stdOutScreenBufferInfo.dwSize);
+	const ConsoleSize bufferSize = sCoordToConsoleSize(_cachedInfo.stdOutScreenBufferInfo.dwSize);
+	ResizeBackBuffer(bufferSize.width, bufferSize.height);
 	_currentBufferViewportRect = sSmallRectToConsoleRect(_cachedInfo.stdOutScreenBufferInfo.srWindow);
 }
 
 ConsoleInterface::~ConsoleInterface()
 {
 	Clear();
+	Present();
 
 	// Restore the initial console state that was cached in the constructor.
 	RestoreInitialConsoleState();
@@ -146,13 +296,6 @@ void ConsoleInterface::RestoreInitialConsoleState()
 	assert(result);
 }
 
-void ConsoleInterface::SetCallbacks(KeyEventCallback keyCb, MouseEventCallback mouseCb, ResizeEventCallback resizeCb)
-{
-	_keyEventCallback = std::move(keyCb);
-	_mouseEventCallback = std::move(mouseCb);
-	_resizeEventCallback = std::move(resizeCb);
-}
-
 void ConsoleInterface::Update()
 {
 	bool receivedResizeEvent = false;
@@ -172,11 +315,31 @@ void ConsoleInterface::Update()
 				switch (eventRecord.EventType)
 				{
 				case KEY_EVENT:
-					_keyEventCallback(eventRecord.Event.KeyEvent);
+				{
+					const KEY_EVENT_RECORD& keyEvent = eventRecord.Event.KeyEvent;
+					_keyEventCallback({
+						keyEvent.wVirtualKeyCode,
+						keyEvent.bKeyDown != FALSE,
+						(keyEvent.dwControlKeyState & (LEFT_CTRL_PRESSED | RIGHT_CTRL_PRESSED)) != 0 });
 					break;
+				}
 				case MOUSE_EVENT:
-					_mouseEventCallback(eventRecord.Event.MouseEvent);
+				{
+					const MOUSE_EVENT_RECORD& mouseEvent = eventRecord.Event.MouseEvent;
+					ConsoleMouseEventType type;
+					switch (mouseEvent.dwEventFlags)
+					{
+					case 0:				type = ConsoleMouseEventType::ButtonChanged; break;
+					case MOUSE_MOVED:	type = ConsoleMouseEventType::Moved; break;
+					case DOUBLE_CLICK:	type = ConsoleMouseEventType::DoubleClicked; break;
+					default:			type = ConsoleMouseEventType::Wheeled; break;
+					}
+					_mouseEventCallback({
+						{ static_cast<uint16_t>(mouseEvent.dwMousePosition.X), static_cast<uint16_t>(mouseEvent.dwMousePosition.Y) },
+						type,
+						(mouseEvent.dwButtonState & FROM_LEFT_1ST_BUTTON_PRESSED) != 0 });
 					break;
+				}
 				case WINDOW_BUFFER_SIZE_EVENT:
 					receivedResizeEvent = true;
 					break;
@@ -195,6 +358,10 @@ void ConsoleInterface::Update()
 
 		if (receivedResizeEvent)
 		{
+			// The console may have rewrapped (or lost) what was on screen.
+			_isBackBufferDirty = true;
+			_isFrontBufferValid = false;
+
 			uint16_t w = _currentBufferViewportRect.GetSize().width;
 			uint16_t h = _currentBufferViewportRect.GetSize().height;
 			if (w != _currentBufferSize.width ||
@@ -207,18 +374,58 @@ void ConsoleInterface::Update()
 	}
 }
 
-void ConsoleInterface::SetMinBufferSize(const ConsoleSize& size)
+void ConsoleInterface::Present()
 {
-	_minBufferSize.width = max(size.width, kAbsoluteMinimumBufferSize.width);
-	_minBufferSize.height = max(size.height, kAbsoluteMinimumBufferSize.height);
+	if (!_isBackBufferDirty)
+	{
+		return;
+	}
 
-	uint16_t w = max(_currentBufferSize.width, _minBufferSize.width);
-	uint16_t h = max(_currentBufferSize.height, _minBufferSize.height);
-	if (w != _currentBufferSize.width ||
-		h != _currentBufferSize.height)
+	// Consecutive rows with changes are written together, as the smallest rectangle holding all of them: a call to
+	// the console costs far more than the unchanged cells it rewrites.
+	const uint16_t maxRegionHeight = static_cast<uint16_t>(std::max<uint32_t>(kMaxRegionCellCount / _currentBufferSize.width, 1));
+	bool isInRegion = false;
+	uint16_t regionLeft = 0;
+	uint16_t regionTop = 0;
+	uint16_t regionRight = 0;
+	for (uint16_t y = 0; y < _currentBufferSize.height; y++)
 	{
-		ResizeBuffer(w, h);
+		uint16_t left;
+		uint16_t right;
+		const bool isChanged = FindChangedSpan(y, &left, &right);
+		if (isInRegion && (!isChanged || y - regionTop == maxRegionHeight))
+		{
+			WriteRegion(regionLeft, regionTop, regionRight, y - 1);
+			isInRegion = false;
+		}
+
+		if (isChanged)
+		{
+			const size_t rowStart = y * _currentBufferSize.width;
+			std::copy_n(&_backBuffer[rowStart + left], right - left + 1, &_frontBuffer[rowStart + left]);
+		}
+
+		if (isChanged && !isInRegion)
+		{
+			regionLeft = left;
+			regionTop = y;
+			regionRight = right;
+			isInRegion = true;
+		}
+		else if (isChanged)
+		{
+			regionLeft = std::min(regionLeft, left);
+			regionRight = std::max(regionRight, right);
+		}
 	}
+	if (isInRegion)
+	{
+		WriteRegion(regionLeft, regionTop, regionRight, _currentBufferSize.height - 1);
+	}
+
+	std::fill(_dirtyRows.begin(), _dirtyRows.end(), 0);
+	_isBackBufferDirty = false;
+	_isFrontBufferValid = true;
 }
 
 bool ConsoleInterface::SetSizes(const ConsoleSize& bufferSize, const ConsoleSize& viewportSize)
@@ -261,6 +468,7 @@ bool ConsoleInterface::SetSizes(const ConsoleSize& bufferSize, const ConsoleSize
 						windowRect.Bottom = viewportSize.height;
 						if (SetConsoleWindowInfo(_stdOutHandle, true, &windowRect))
 						{
+							ResizeBackBuffer(bufferSize.width, bufferSize.height);
 							result = true;
 						}
 
@@ -291,25 +499,581 @@ ConsoleSize ConsoleInterface::GetMaximumBufferViewportSize() const
 
 void ConsoleInterface::ResizeBuffer(uint16_t w, uint16_t h)
 {
-	w = max(w, _minBufferSize.width);
-	h = max(h, _minBufferSize.height);
+	w = std::max(w, _minBufferSize.width);
+	h = std::max(h, _minBufferSize.height);
 
-	_currentBufferSize = { w, h };
-	SetConsoleScreenBufferSize(_stdOutHandle, sConsoleSizeToCoord(_currentBufferSize));
+	SetConsoleScreenBufferSize(_stdOutHandle, sConsoleSizeToCoord({ w, h }));
+	ResizeBackBuffer(w, h);
 }
 
+// Copies a rectangle of the back buffer to the screen buffer in one call.
+void ConsoleInterface::WriteRegion(uint16_t left, uint16_t top, uint16_t right, uint16_t bottom)
+{
+	const ConsoleSize regionSize = ConsoleRect{ left, top, right, bottom }.GetSize();
+	_region.resize(static_cast<size_t>(regionSize.width) * regionSize.height);
+
+	CHAR_INFO* charInfo = _region.data();
+	for (uint16_t y = top; y <= bottom; y++)
+	{
+		const Cell* cell = &_backBuffer[(y * _currentBufferSize.width) + left];
+		for (uint16_t x = left; x <= right; x++, cell++, charInfo++)
+		{
+			charInfo->Char.AsciiChar = cell->c;
+			charInfo->Attributes = cell->attributes;
+		}
+	}
+
+	SMALL_RECT writeRect = sConsoleRectToSmallRect({ left, top, right, bottom });
+	WriteConsoleOutputA(_stdOutHandle, _region.data(), sConsoleSizeToCoord(regionSize), { 0, 0 }, &writeRect);
+}
+
+static COORD sConsoleSizeToCoord(const ConsoleSize& size)
+{
+	return {
+		static_cast<SHORT>(size.width),
+		static_cast<SHORT>(size.height)
+	};
+}
+
+static ConsoleSize sCoordToConsoleSize(const COORD& coord)
+{
+	return {
+		static_cast<uint16_t>(coord.X),
+		static_cast<uint16_t>(coord.Y)
+	};
+}
+
+static SMALL_RECT sConsoleRectToSmallRect(const ConsoleRect& rect)
+{
+	return {
+		static_cast<SHORT>(rect.left),
+		static_cast<SHORT>(rect.top),
+		static_cast<SHORT>(rect.right),
+		static_cast<SHORT>(rect.bottom)
+	};
+}
+
+static ConsoleRect sSmallRectToConsoleRect(const SMALL_RECT& rect)
+{
+	return {
+		static_cast<uint16_t>(rect.Left),
+		static_cast<uint16_t>(rect.Top),
+		static_cast<uint16_t>(rect.Right),
+		static_cast<uint16_t>(rect.Bottom)
+	};
+}
+
+#else
+
+ConsoleInterface::ConsoleInterface() :
+	_initialTermios(),
+	_frame(),
+	_input(),
+	_lastInputTime(),
+	_isLeftButtonDown(false),
+	_lastClickPosition(),
+	_lastClickTime(),
+	_keyEventCallback(nullptr),
+	_mouseEventCallback(nullptr),
+	_resizeEventCallback(nullptr),
+	_backBuffer(),
+	_frontBuffer(),
+	_dirtyRows(),
+	_isBackBufferDirty(true),
+	_isFrontBufferValid(false),
+	_minBufferSize(kAbsoluteMinimumBufferSize),
+	_currentBufferSize(),
+	_currentBufferViewportRect()
+{
+	// Cache the initial terminal state to be restored in the destructor.
+	SaveInitialConsoleState();
+
+	// Change to raw mode, so that input is read a byte at a time without echoing or waiting. Ctrl+C still
+	// interrupts, but the suspend keys are disabled so that Ctrl+Z & Ctrl+Y reach the game.
+	termios rawTermios = _initialTermios;
+	rawTermios.c_iflag &= ~(BRKINT | ICRNL | INPCK | ISTRIP | IXON);
+	rawTermios.c_lflag &= ~(ECHO | ICANON | IEXTEN);
+	rawTermios.c_cc[VMIN] = 0;
+	rawTermios.c_cc[VTIME] = 0;
+	rawTermios.c_cc[VSUSP] = _POSIX_VDISABLE;
+#ifdef VDSUSP
+	rawTermios.c_cc[VDSUSP] = _POSIX_VDISABLE;
+#endif
+	int result = tcsetattr(STDIN_FILENO, TCSAFLUSH, &rawTermios);
+	assert(result == 0);
+	(void)result;
+
+	sgIsResizePending = 0;
+	signal(SIGWINCH, sOnResizeSignal);
+	sWriteAll(kEnterSequence, sizeof(kEnterSequence) - 1);
+	sgIsLeaveSequencePending = 1;
+
+	// The terminal can't be scrolled, so the viewport is always the whole terminal at the top-left of the buffer.
+	const ConsoleSize terminalSize = sGetTerminalSize();
+	_currentBufferViewportRect = { 0, 0, static_cast<uint16_t>(terminalSize.width - 1), static_cast<uint16_t>(terminalSize.height - 1) };
+	ResizeBuffer(terminalSize.width, terminalSize.height);
+}
+
+ConsoleInterface::~ConsoleInterface()
+{
+	// Restore the initial terminal state that was cached in the constructor.
+	RestoreInitialConsoleState();
+}
+
+void ConsoleInterface::SaveInitialConsoleState()
+{
+	int result = tcgetattr(STDIN_FILENO, &_initialTermios);
+	assert(result == 0);
+	(void)result;
+}
+
+void ConsoleInterface::RestoreInitialConsoleState()
+{
+	WriteLeaveSequence();
+	sgIsLeaveSequencePending = 0;
+	signal(SIGWINCH, SIG_DFL);
+
+	int result = tcsetattr(STDIN_FILENO, TCSAFLUSH, &_initialTermios);
+	assert(result == 0);
+	(void)result;
+}
+
+void ConsoleInterface::WriteLeaveSequence()
+{
+	if (sgIsLeaveSequencePending)
+	{
+		sWriteAll(kLeaveSequence, sizeof(kLeaveSequence) - 1);
+	}
+}
+
+void ConsoleInterface::Update()
+{
+	ReadInput();
+
+	if (sgIsResizePending)
+	{
+		sgIsResizePending = 0;
+
+		// The terminal may have rewrapped (or lost) what was on screen.
+		_isBackBufferDirty = true;
+		_isFrontBufferValid = false;
+
+		const ConsoleSize terminalSize = sGetTerminalSize();
+		_currentBufferViewportRect = { 0, 0, static_cast<uint16_t>(terminalSize.width - 1), static_cast<uint16_t>(terminalSize.height - 1) };
+		if (terminalSize.width != _currentBufferSize.width ||
+			terminalSize.height != _currentBufferSize.height)
+		{
+			ResizeBuffer(terminalSize.width, terminalSize.height);
+			_resizeEventCallback(_currentBufferSize);
+		}
+	}
+}
+
+void ConsoleInterface::Present()
+{
+	if (_isBackBufferDirty)
+	{
+		WriteFrame();
+		std::fill(_dirtyRows.begin(), _dirtyRows.end(), 0);
+		_isBackBufferDirty = false;
+		_isFrontBufferValid = true;
+	}
+}
+
+bool ConsoleInterface::SetSizes(const ConsoleSize& bufferSize, const ConsoleSize& viewportSize)
+{
+	// Only the user can resize a terminal, so only the buffer changes.
+	(void)viewportSize;
+	if (bufferSize.width < _minBufferSize.width ||
+		bufferSize.height < _minBufferSize.height)
+	{
+		assert(!"bufferSize must be larger than _minBufferSize");
+		return false;
+	}
+
+	ResizeBuffer(bufferSize.width, bufferSize.height);
+	return true;
+}
+
+ConsoleSize ConsoleInterface::GetMaximumBufferViewportSize() const
+{
+	return sGetTerminalSize();
+}
+
+void ConsoleInterface::ResizeBuffer(uint16_t w, uint16_t h)
+{
+	w = std::max(w, _minBufferSize.width);
+	h = std::max(h, _minBufferSize.height);
+
+	ResizeBackBuffer(w, h);
+}
+
+void ConsoleInterface::ReadInput()
+{
+	char buffer[256];
+	ssize_t readCount;
+	while ((readCount = read(STDIN_FILENO, buffer, sizeof(buffer))) > 0)
+	{
+		_input.append(buffer, static_cast<size_t>(readCount));
+		_lastInputTime = std::chrono::steady_clock::now();
+	}
+
+	// A sequence that's been cut short is left for the next update, when the rest of it will have arrived.
+	size_t offset = 0;
+	while (offset < _input.size())
+	{
+		const size_t length = ParseInput(offset);
+		if (length == 0)
+		{
+			break;
+		}
+		offset += length;
+	}
+	_input.erase(0, offset);
+}
+
+// Returns the length of the key or escape sequence at the given offset, or 0 if it's incomplete.
+size_t ConsoleInterface::ParseInput(size_t offset)
+{
+	const uint8_t c = static_cast<uint8_t>(_input[offset]);
+	const size_t remaining = _input.size() - offset;
+
+	ConsoleKeyEvent event = { c, true, false };
+	if (c == kConsoleKeyEscape && remaining == 1)
+	{
+		if (std::chrono::steady_clock::now() - _lastInputTime < kEscapeKeyTime)
+		{
+			return 0;
+		}
+	}
+	else if (c == kConsoleKeyEscape)
+	{
+		switch (_input[offset + 1])
+		{
+			case '[':
+				if (remaining > 2 && _input[offset + 2] == '<')
+				{
+					return ParseMouseReport(offset);
+				}
+
+				// Any other control sequence (e.g. a cursor key) is skipped, up to and including its final byte.
+				for (size_t i = offset + 2; i < _input.size(); i++)
+				{
+					if (_input[i] >= 0x40 && _input[i] <= 0x7E)
+					{
+						return i - offset + 1;
+					}
+				}
+				return 0;
+
+			case 'O':
+				// As are the 3 byte sequences of function keys.
+				return (remaining > 2) ? 3 : 0;
+
+			default:
+				// Otherwise the escape key was pressed just before another key (or with Alt).
+				break;
+		}
+	}
+	else if (c >= 'a' && c <= 'z')
+	{
+		event.keyCode = c - 'a' + 'A';
+	}
+	else if (c == '\r' || c == '\n')
+	{
+		event.keyCode = kConsoleKeyReturn;
+	}
+	else if (c == '\b' || c == 0x7F)
+	{
+		event.keyCode = kConsoleKeyBack;
+	}
+	else if (c == '\t')
+	{
+		event.keyCode = kConsoleKeyTab;
+	}
+	else if (c >= 0x01 && c <= 0x1A)
+	{
+		// Ctrl+A to Ctrl+Z.
+		event.keyCode = c - 0x01 + 'A';
+		event.isCtrlPressed = true;
+	}
+
+	// Terminals only send presses, so no key is ever reported as released.
+	_keyEventCallback(event);
+	return 1;
+}
+
+// Parses an SGR mouse report: "ESC [ < button ; x ; y" then 'M' for a press or motion, or 'm' for a release.
+// Returns its length, or 0 if it's incomplete.
+size_t ConsoleInterface::ParseMouseReport(size_t offset)
+{
+	uint32_t values[3] = { 0, 0, 0 };
+	uint32_t valueIndex = 0;
+	size_t i = offset + 3;
+	for (; i < _input.size(); i++)
+	{
+		const char c = _input[i];
+		if (c >= '0' && c <= '9' && values[valueIndex] < UINT16_MAX)
+		{
+			values[valueIndex] = (values[valueIndex] * 10) + (c - '0');
+		}
+		else if (c == ';' && valueIndex < 2)
+		{
+			valueIndex++;
+		}
+		else if ((c == 'M' || c == 'm') && valueIndex == 2)
+		{
+			break;
+		}
+		else
+		{
+			// Not a report after all; drop it.
+			return i - offset + 1;
+		}
+	}
+	if (i == _input.size())
+	{
+		return 0;
+	}
+
+	const uint32_t button = values[0];
+	const bool isRelease = (_input[i] == 'm');
+
+	ConsoleMouseEvent event;
+	event.position = {
+		static_cast<uint16_t>((values[1] > 0) ? (values[1] - 1) : 0),
+		static_cast<uint16_t>((values[2] > 0) ? (values[2] - 1) : 0) };
+
+	if (button & 64)
+	{
+		event.type = ConsoleMouseEventType::Wheeled;
+	}
+	else if (button & 32)
+	{
+		event.type = ConsoleMouseEventType::Moved;
+	}
+	else
+	{
+		event.type = ConsoleMouseEventType::ButtonChanged;
+		if ((button & 3) == 0)
+		{
+			_isLeftButtonDown = !isRelease;
+			if (!isRelease)
+			{
+				const auto now = std::chrono::steady_clock::now();
+				if (now - _lastClickTime <= kDoubleClickTime &&
+					event.position.x == _lastClickPosition.x &&
+					event.position.y == _lastClickPosition.y)
+				{
+					// A third press starts a new double click rather than finishing another one.
+					event.type = ConsoleMouseEventType::DoubleClicked;
+					_lastClickTime = std::chrono::steady_clock::time_point();
+				}
+				else
+				{
+					_lastClickTime = now;
+					_lastClickPosition = event.position;
+				}
+			}
+		}
+	}
+	event.isLeftButtonDown = _isLeftButtonDown;
+
+	_mouseEventCallback(event);
+	return i - offset + 1;
+}
+
+// Composes the changes to the visible part of the buffer into one string of VT sequences, so that a frame is a
+// single write() however much was drawn. Colors are only set where they change.
+void ConsoleInterface::WriteFrame()
+{
+	const ConsoleSize viewportSize = _currentBufferViewportRect.GetSize();
+	const uint16_t width = std::min(viewportSize.width, _currentBufferSize.width);
+	const uint16_t height = std::min(viewportSize.height, _currentBufferSize.height);
+
+	_frame.clear();
+	if (!_isFrontBufferValid)
+	{
+		// Nothing on screen is known, including anything outside the buffer, so start from a blank screen.
+		_frame += "\x1b[0m\x1b[2J";
+	}
+
+	uint32_t currentAttributes = UINT32_MAX;
+	auto appendCell = [&](const Cell& cell)
+	{
+		if (cell.attributes != currentAttributes)
+		{
+			// The console's color bits are blue, green, red & intensity, where ANSI colors are red, green & blue.
+			const uint32_t foreground = cell.attributes & 0xF;
+			const uint32_t background = cell.attributes >> 4;
+			auto toAnsi = [](uint32_t color)
+			{
+				return ((color & 0x4) ? 1u : 0u) | (color & 0x2) | ((color & 0x1) ? 4u : 0u);
+			};
+
+			_frame += "\x1b[";
+			sAppendNumber(_frame, ((foreground & 0x8) ? 90 : 30) + toAnsi(foreground));
+			_frame += ';';
+			sAppendNumber(_frame, ((background & 0x8) ? 100 : 40) + toAnsi(background));
+			_frame += 'm';
+			currentAttributes = cell.attributes;
+		}
+		_frame += (cell.c >= ' ' && cell.c <= '~') ? cell.c : ' ';
+	};
+
+	for (uint16_t y = 0; y < height; y++)
+	{
+		uint16_t left;
+		uint16_t right;
+		if (!FindChangedSpan(y, &left, &right) || left >= width)
+		{
+			continue;
+		}
+		right = std::min<uint16_t>(right, width - 1);
+
+		const Cell* back = &_backBuffer[y * _currentBufferSize.width];
+		const Cell* front = &_frontBuffer[y * _currentBufferSize.width];
+		uint16_t cursorX = UINT16_MAX;
+		for (uint16_t x = left; x <= right; x++)
+		{
+			if (_isFrontBufferValid && back[x] == front[x])
+			{
+				continue;
+			}
+
+			if (cursorX != UINT16_MAX && x - cursorX <= kMaxRewrittenCellCount)
+			{
+				for (; cursorX < x; cursorX++)
+				{
+					appendCell(back[cursorX]);
+				}
+			}
+			else
+			{
+				// Move the cursor (CUP), rather than relying on the terminal's line wrapping.
+				_frame += "\x1b[";
+				sAppendNumber(_frame, y + 1);
+				_frame += ';';
+				sAppendNumber(_frame, x + 1);
+				_frame += 'H';
+			}
+
+			appendCell(back[x]);
+			cursorX = x + 1;
+		}
+
+		// Only what's visible is written, so only that is known to be on screen.
+		std::copy_n(back + left, right - left + 1, &_frontBuffer[(y * _currentBufferSize.width) + left]);
+	}
+
+	if (!_frame.empty())
+	{
+		sWriteAll(_frame.data(), _frame.size());
+	}
+}
+
+static void sOnResizeSignal(int signal)
+{
+	(void)signal;
+	sgIsResizePending = 1;
+}
+
+static ConsoleSize sGetTerminalSize()
+{
+	winsize size;
+	if (ioctl(STDOUT_FILENO, TIOCGWINSZ, &size) != 0 || size.ws_col == 0 || size.ws_row == 0)
+	{
+		return { 80, 24 };
+	}
+	return { size.ws_col, size.ws_row };
+}
+
+static void sWriteAll(const char* data, size_t size)
+{
+	// A write() to a terminal normally takes everything at once, but may be interrupted or cut short.
+	while (size > 0)
+	{
+		const ssize_t writtenCount = write(STDOUT_FILENO, data, size);
+		if (writtenCount < 0)
+		{
+			if (errno == EINTR)
+			{
+				continue;
+			}
+			return;
+		}
+		data += writtenCount;
+		size -= static_cast<size_t>(writtenCount);
+	}
+}
+
+static void sAppendNumber(std::string& str, uint32_t value)
+{
+	char digits[10];
+	uint32_t digitCount = 0;
+	do
+	{
+		digits[digitCount++] = static_cast<char>('0' + (value % 10));
+		value /= 10;
+	} while (value > 0);
+
+	while (digitCount > 0)
+	{
+		str += digits[--digitCount];
+	}
+}
+
+#endif
+
 void ConsoleInterface::DrawChar(char c, uint16_t x, uint16_t y, const ConsoleColor& color, const ConsoleColor& backgroundColor)
 {
-	COORD coord = { static_cast<SHORT>(x), static_cast<SHORT>(y) };
-	WORD attributes = sConsoleColorsToAttributes(color, backgroundColor);
-	DWORD dummy;
-	WriteConsoleOutputAttribute(_stdOutHandle, &attributes, 1, coord, &dummy);
-	WriteConsoleOutputCharacterA(_stdOutHandle, &c, 1, coord, &dummy);
+	// Like the console API, anything outside the buffer is clipped.
+	if (x >= _currentBufferSize.width || y >= _currentBufferSize.height)
+	{
+		return;
+	}
+
+	Cell& cell = _backBuffer[(y * _currentBufferSize.width) + x];
+	cell.c = c;
+	cell.attributes = sConsoleColorsToAttributes(color, backgroundColor);
+	_dirtyRows[y] = 1;
+	_isBackBufferDirty = true;
+}
+
+void ConsoleInterface::Clear()
+{
+	std::fill(_backBuffer.begin(), _backBuffer.end(), Cell{ ' ', kClearAttributes });
+	MarkRowsDirty(0, _currentBufferSize.height - 1);
+}
+
+// Fills a rectangle of the back buffer (clipped to it) a row at a time, rather than a cell at a time.
+void ConsoleInterface::FillCells(uint16_t left, uint16_t top, uint16_t right, uint16_t bottom, const Cell& cell)
+{
+	if (left > right || top > bottom ||
+		left >= _currentBufferSize.width || top >= _currentBufferSize.height)
+	{
+		return;
+	}
+	right = std::min<uint16_t>(right, _currentBufferSize.width - 1);
+	bottom = std::min<uint16_t>(bottom, _currentBufferSize.height - 1);
+
+	const size_t rowCellCount = right - left + 1;
+	for (uint16_t y = top; y <= bottom; y++)
+	{
+		std::fill_n(&_backBuffer[(y * _currentBufferSize.width) + left], rowCellCount, cell);
+	}
+	MarkRowsDirty(top, bottom);
+}
+
+void ConsoleInterface::MarkRowsDirty(uint16_t top, uint16_t bottom)
+{
+	std::fill(_dirtyRows.begin() + top, _dirtyRows.begin() + bottom + 1, 1);
+	_isBackBufferDirty = true;
 }
 
 void ConsoleInterface::DrawString(const char* str, uint16_t x, uint16_t y, const ConsoleColor& color, const ConsoleColor& backgroundColor)
 {
-	while (*str != NULL &&
+	while (*str != '\0' &&
 		(x >= 0 && x < _currentBufferSize.width) &&
 		(y >= 0 && y < _currentBufferSize.height))
 	{
@@ -327,6 +1091,14 @@ void ConsoleInterface::DrawPixel(uint16_t x, uint16_t y, const ConsoleColor& col
 // Reference: https://en.wikipedia.org/wiki/Bresenham%27s_line_algorithm
 void ConsoleInterface::DrawLine(uint16_t x0, uint16_t y0, uint16_t x1, uint16_t y1, const ConsoleColor& color)
 {
+	// Horizontal & vertical lines (like every border) are filled as spans; only diagonals need stepping through.
+	if (x0 == x1 || y0 == y1)
+	{
+		const Cell cell = { ' ', sConsoleColorsToAttributes(color, color) };
+		FillCells(std::min(x0, x1), std::min(y0, y1), std::max(x0, x1), std::max(y0, y1), cell);
+		return;
+	}
+
 	bool isVertical = abs(y1 - y0) > abs(x1 - x0);
 
 	// The base algorithm assumes horizontal-ish lines; swap the x/y values if it's more vertical-ish.
@@ -413,64 +1185,85 @@ void ConsoleInterface::DrawRectangle(uint16_t x0, uint16_t y0, uint16_t x1, uint
 	assert(x0 < x1);
 	assert(y0 < y1);
 
-	DrawLine(x0, y0, x1, y0, color);
-	for (int16_t y = y0 + 1; y <= y1 - 1; y++)
-	{
-		DrawPixel(x0, y, color);
-		DrawLine(x0 + 1, y, x1 - 1, y, fillColor);
-		DrawPixel(x1, y, color);
-	}
-	DrawLine(x0, y1, x1, y1, color);
-}
-
-void ConsoleInterface::Clear()
-{
-	COORD topLeft = { 0, 0 };
-	DWORD bufferSize = _currentBufferSize.width * _currentBufferSize.height;
-	DWORD dummy;
-	FillConsoleOutputCharacterA(_stdOutHandle, ' ', bufferSize, topLeft, &dummy);
-	FillConsoleOutputAttribute(_stdOutHandle, 0, bufferSize, topLeft, &dummy);
-}
+	const Cell borderCell = { ' ', sConsoleColorsToAttributes(color, color) };
+	const Cell fillCell = { ' ', sConsoleColorsToAttributes(fillColor, fillColor) };
 
-static WORD sConsoleColorsToAttributes(const ConsoleColor& foregroundColor, const ConsoleColor& backgroundColor)
-{
-	WORD foreground = static_cast<WORD>(foregroundColor);
-	WORD background = static_cast<WORD>(backgroundColor);
-	return foreground + (background * 16);
-}
-
-static COORD sConsoleSizeToCoord(const ConsoleSize& size)
-{
-	return {
-		static_cast<SHORT>(size.width),
-		static_cast<SHORT>(size.height)
-	};
+	FillCells(x0, y0, x1, y0, borderCell);
+	FillCells(x0, y0 + 1, x0, y1 - 1, borderCell);
+	FillCells(x0 + 1, y0 + 1, x1 - 1, y1 - 1, fillCell);
+	FillCells(x1, y0 + 1, x1, y1 - 1, borderCell);
+	FillCells(x0, y1, x1, y1, borderCell);
 }
 
-static ConsoleSize sCoordToConsoleSize(const COORD& coord)
+// Markers & the like are only a few cells in short runs, so a sprite is copied a cell at a time: a call to copy
+// each run (which is what a loop copying one becomes) costs more than the cells it copies.
+void ConsoleInterface::DrawSprite(const Sprite& sprite, uint16_t x, uint16_t y)
 {
-	return {
-		static_cast<uint16_t>(coord.X),
-		static_cast<uint16_t>(coord.Y)
-	};
+	const uint32_t bufferWidth = _currentBufferSize.width;
+	if (static_cast<uint32_t>(x) + sprite._size.width <= bufferWidth &&
+		static_cast<uint32_t>(y) + sprite._size.height <= _currentBufferSize.height)
+	{
+		// The whole sprite is inside the buffer, so no cell needs clipping.
+		Cell* origin = &_backBuffer[(y * bufferWidth) + x];
+		for (const Sprite::OpaqueCell& opaqueCell : sprite._opaqueCells)
+		{
+			origin[(opaqueCell.y * bufferWidth) + opaqueCell.x] = opaqueCell.cell;
+		}
+		MarkRowsDirty(y, y + sprite._size.height - 1);
+	}
+	else
+	{
+		for (const Sprite::OpaqueCell& opaqueCell : sprite._opaqueCells)
+		{
+			const uint32_t cellX = x + opaqueCell.x;
+			const uint32_t cellY = y + opaqueCell.y;
+			if (cellX < bufferWidth && cellY < _currentBufferSize.height)
+			{
+				_backBuffer[(cellY * bufferWidth) + cellX] = opaqueCell.cell;
+				_dirtyRows[cellY] = 1;
+			}
+		}
+		_isBackBufferDirty = true;
+	}
 }
 
-static SMALL_RECT sConsoleRectToSmallRect(const ConsoleRect& rect)
+ConsoleInterface::Sprite ConsoleInterface::RasterizeSprite(const ConsoleSize& size, const std::function<void()>& draw)
 {
-	return {
-		static_cast<SHORT>(rect.left),
-		static_cast<SHORT>(rect.top),
-		static_cast<SHORT>(rect.right),
-		static_cast<SHORT>(rect.bottom)
-	};
+	// Stand a blank buffer of the sprite's size in for the back buffer, so that every draw call works on it as is.
+	std::vector<Cell> spriteBuffer(static_cast<size_t>(size.width) * size.height, { kTransparentChar, 0 });
+	std::vector<uint8_t> spriteDirtyRows(size.height, 0);
+	const ConsoleSize bufferSize = _currentBufferSize;
+	const bool isBackBufferDirty = _isBackBufferDirty;
+
+	_backBuffer.swap(spriteBuffer);
+	_dirtyRows.swap(spriteDirtyRows);
+	_currentBufferSize = size;
+	draw();
+	_backBuffer.swap(spriteBuffer);
+	_dirtyRows.swap(spriteDirtyRows);
+	_currentBufferSize = bufferSize;
+	_isBackBufferDirty = isBackBufferDirty;
+
+	// Keep only the cells that were drawn.
+	Sprite sprite;
+	sprite._size = size;
+	for (uint16_t y = 0; y < size.height; y++)
+	{
+		for (uint16_t x = 0; x < size.width; x++)
+		{
+			const Cell& cell = spriteBuffer[(y * size.width) + x];
+			if (cell.c != kTransparentChar)
+			{
+				sprite._opaqueCells.push_back({ x, y, cell });
+			}
+		}
+	}
+	return sprite;
 }
 
-static ConsoleRect sSmallRectToConsoleRect(const SMALL_RECT& rect)
+static uint8_t sConsoleColorsToAttributes(const ConsoleColor& foregroundColor, const ConsoleColor& backgroundColor)
 {
-	return {
-		static_cast<uint16_t>(rect.Left),
-		static_cast<uint16_t>(rect.Top),
-		static_cast<uint16_t>(rect.Right),
-		static_cast<uint16_t>(rect.Bottom)
-	};
+	uint8_t foreground = static_cast<uint8_t>(foregroundColor);
+	uint8_t background = static_cast<uint8_t>(backgroundColor);
+	return foreground + (background * 16);
 }
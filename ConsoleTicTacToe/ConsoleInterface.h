@@ -2,25 +2,35 @@
 
 #include <cstdint>
 #include <functional>
+#include <vector>
 
+#ifdef _WIN32
 #define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
 #include <windows.h>
+#else
+#include <chrono>
+#include <string>
+
+#include <termios.h>
+#endif
 
 namespace tictactoe
 {
+	// Colors are the bits of a Win32 console character attribute (FOREGROUND_BLUE etc.) on every platform.
 	enum class ConsoleColor
 	{
 		Black =			0,
 
-		DarkBlue =		FOREGROUND_BLUE,
-		DarkGreen =		FOREGROUND_GREEN,
+		DarkBlue =		0x1,
+		DarkGreen =		0x2,
 		DarkCyan =		DarkGreen | DarkBlue,
-		DarkRed =		FOREGROUND_RED,
+		DarkRed =		0x4,
 		DarkMagenta =	DarkRed | DarkBlue,
 		DarkYellow =	DarkRed | DarkGreen,
 		DarkGray =		DarkRed | DarkGreen | DarkBlue,
 
-		LightGray =		FOREGROUND_INTENSITY,
+		LightGray =		0x8,
 		LightBlue =		LightGray | DarkBlue,
 		LightGreen =	LightGray | DarkGreen,
 		LightCyan =		LightGray | DarkCyan,
@@ -53,14 +63,78 @@ namespace tictactoe
 		ConsoleSize GetSize() const;
 	};
 
-	// An interface for rendering (faking) simple graphics in a Windows console.
+	// Key codes are Win32 virtual key codes, so letters, digits & space are their (upper case) ASCII characters.
+	static const uint16_t kConsoleKeyEscape = 0x1B;
+	static const uint16_t kConsoleKeySpace = 0x20;
+
+	struct ConsoleKeyEvent
+	{
+		uint16_t keyCode;
+		bool isKeyDown;
+		bool isCtrlPressed;
+	};
+
+	enum class ConsoleMouseEventType
+	{
+		ButtonChanged = 0,	// A button was pressed or released.
+		Moved,
+		DoubleClicked,		// The second press of a double click (the first is a ButtonChanged).
+		Wheeled,
+
+		Count
+	};
+
+	struct ConsoleMouseEvent
+	{
+		ConsoleCoord position;
+		ConsoleMouseEventType type;
+		bool isLeftButtonDown;
+	};
+
+	// An interface for rendering (faking) simple graphics in a console.
 	// Overwrites many user-defined console preferences to achieve this. Those preferences are restored on destruct.
-	// Reference: https://docs.microsoft.com/en-us/windows/console/
+	//
+	// Draws go to an in-memory back buffer. Present() compares it with a front buffer holding what's on screen, and
+	// only writes out the cells that differ: with WriteConsoleOutput() on Windows, or elsewhere (where the terminal is
+	// put in raw mode, and keys & SGR mouse reports are read from stdin) as VT escape sequences in a single write().
+	// References: https://docs.microsoft.com/en-us/windows/console/,
+	// https://invisible-island.net/xterm/ctlseqs/ctlseqs.html
 	class ConsoleInterface
 	{
+	private:
+		struct Cell
+		{
+			char c;
+			uint8_t attributes;	// The foreground color in the low 4 bits and the background color in the high 4.
+
+			bool operator==(const Cell& other) const { return c == other.c && attributes == other.attributes; }
+		};
+
 	public:
-		typedef std::function<void(const KEY_EVENT_RECORD&)> KeyEventCallback;
-		typedef std::function<void(const MOUSE_EVENT_RECORD&)> MouseEventCallback;
+		// A block of cells rasterized once by RasterizeSprite(), then copied by DrawSprite() wherever it's needed.
+		// Cells that weren't drawn when it was rasterized are transparent.
+		class Sprite
+		{
+		public:
+			const ConsoleSize& GetSize() const { return _size; }
+
+		private:
+			friend class ConsoleInterface;
+
+			struct OpaqueCell
+			{
+				uint16_t x;
+				uint16_t y;
+				Cell cell;
+			};
+
+			ConsoleSize _size;
+			std::vector<OpaqueCell> _opaqueCells;
+		};
+
+	public:
+		typedef std::function<void(const ConsoleKeyEvent&)> KeyEventCallback;
+		typedef std::function<void(const ConsoleMouseEvent&)> MouseEventCallback;
 		typedef std::function<void(const ConsoleSize&)> ResizeEventCallback;
 
 		ConsoleInterface();
@@ -70,6 +144,9 @@ namespace tictactoe
 
 		void Update();
 
+		// Shows everything drawn since the last call, writing out only what has changed.
+		void Present();
+
 		void SetMinBufferSize(const ConsoleSize& size);
 		bool SetSizes(const ConsoleSize& bufferSize, const ConsoleSize& viewportSize);
 
@@ -84,12 +161,31 @@ namespace tictactoe
 		void DrawLine(uint16_t x0, uint16_t y0, uint16_t x1, uint16_t y1, const ConsoleColor& color);
 		void DrawCircle(uint16_t x, uint16_t y, uint16_t r, const ConsoleColor& color);
 		void DrawRectangle(uint16_t x0, uint16_t y0, uint16_t x1, uint16_t y1, const ConsoleColor& color, const ConsoleColor& fillColor);
+		void DrawSprite(const Sprite& sprite, uint16_t x, uint16_t y);
 		void Clear();
 
+		// Makes a sprite of what the draw function draws, with the top-left of the sprite at (0, 0).
+		Sprite RasterizeSprite(const ConsoleSize& size, const std::function<void()>& draw);
+
+#ifndef _WIN32
+		// Undoes what the constructor sets up on the terminal besides its termios settings (the alternate screen,
+		// the hidden cursor & mouse reporting), if a ConsoleInterface has set it up. Only calls write(), so it's
+		// safe to call from a signal handler.
+		static void WriteLeaveSequence();
+#endif
+
 	private:
 		void ResizeBuffer(uint16_t w, uint16_t h);
+		void ResizeBackBuffer(uint16_t w, uint16_t h);
+		bool FindChangedSpan(uint16_t y, uint16_t* outLeft, uint16_t* outRight) const;
+		void FillCells(uint16_t left, uint16_t top, uint16_t right, uint16_t bottom, const Cell& cell);
+		void MarkRowsDirty(uint16_t top, uint16_t bottom);
 
 	private:
+		void SaveInitialConsoleState();
+		void RestoreInitialConsoleState();
+
+#ifdef _WIN32
 		struct CachedInfo
 		{
 			DWORD stdInMode;
@@ -98,17 +194,39 @@ namespace tictactoe
 			CONSOLE_FONT_INFOEX stdOutFontInfo;
 			CONSOLE_CURSOR_INFO stdOutCursorInfo;
 		};
-		void SaveInitialConsoleState();
-		void RestoreInitialConsoleState();
+
+		void WriteRegion(uint16_t left, uint16_t top, uint16_t right, uint16_t bottom);
 
 		HANDLE _stdInHandle;
 		HANDLE _stdOutHandle;
 		CachedInfo _cachedInfo;
-		
+		std::vector<CHAR_INFO> _region;
+#else
+		void ReadInput();
+		size_t ParseInput(size_t offset);
+		size_t ParseMouseReport(size_t offset);
+		void WriteFrame();
+
+		termios _initialTermios;
+		std::string _frame;
+
+		std::string _input;
+		std::chrono::steady_clock::time_point _lastInputTime;
+		bool _isLeftButtonDown;
+		ConsoleCoord _lastClickPosition;
+		std::chrono::steady_clock::time_point _lastClickTime;
+#endif
+
 		KeyEventCallback _keyEventCallback;
 		MouseEventCallback _mouseEventCallback;
 		ResizeEventCallback _resizeEventCallback;
 
+		std::vector<Cell> _backBuffer;
+		std::vector<Cell> _frontBuffer;
+		std::vector<uint8_t> _dirtyRows;	// Which rows have been drawn on since the last Present().
+		bool _isBackBufferDirty;		// Whether anything has been drawn since the last Present().
+		bool _isFrontBufferValid;		// Whether the front buffer is known to match the screen.
+
 		ConsoleSize _minBufferSize;
 		ConsoleSize _currentBufferSize;
 		ConsoleRect _currentBufferViewportRect;
@@ -1,5 +1,8 @@
 #include "FancyGame.h"
 
+#include <algorithm>
+#include <cstdio>
+
 using namespace tictactoe;
 
 #define MARK_SIZE	5
@@ -18,6 +21,7 @@ static BoardPosition sGetBoardPosition(uint16_t x, uint16_t y);
 static ConsoleRect sGetBorderRect(uint16_t r, uint16_t c);
 static ConsoleRect sGetMarkerRect(uint16_t r, uint16_t c);
 static bool sConsoleRectIntersect(const ConsoleRect& a, const ConsoleRect& b);
+static uint64_t sGetMarkerSpriteKey(PlayerID playerID, ConsoleColor color, const ConsoleSize& size);
 
 ConsoleColor FancyGame::GetPlayerColor(PlayerID playerID)
 {
@@ -33,17 +37,20 @@ ConsoleColor FancyGame::GetPlayerColor(PlayerID playerID)
 FancyGame::FancyGame(uint16_t m, uint16_t n, uint16_t k) :
 	GameSimulation(m, n, k),
 	_consoleInterface(),
+	_markerSprites(),
 	_isGameAreaDirty(true),
 	_isInfoPanelDirty(true),
 	_isMouseCellMarkerDirty(true),
 	_isQuitRequested(false),
+	_dirtyRects(),
+	_highlightedCells(),
 	_currentMouseCell(kInvalidBoardPosition),
 	_prevMouseCell(kInvalidBoardPosition),
 	_prevViewportRect()
 {
 	_consoleInterface.SetCallbacks(
-		[=](const KEY_EVENT_RECORD& event) { this->OnKeyEvent(event); },
-		[=](const MOUSE_EVENT_RECORD& event) { this->OnMouseEvent(event); },
+		[=](const ConsoleKeyEvent& event) { this->OnKeyEvent(event); },
+		[=](const ConsoleMouseEvent& event) { this->OnMouseEvent(event); },
 		[=](const ConsoleSize& newSize) { this->OnResizeEvent(newSize); });
 
 	ConsoleSize minBufferSize;
@@ -57,18 +64,21 @@ FancyGame::FancyGame(uint16_t m, uint16_t n, uint16_t k) :
 		const ConsoleSize currentViewportSize = _consoleInterface.GetCurrentBufferViewportRect().GetSize();
 
 		ConsoleSize viewportSize;
-		viewportSize.width = min(minBufferSize.width, currentViewportSize.width);
-		viewportSize.height = min(minBufferSize.height, currentViewportSize.height);
+		viewportSize.width = std::min(minBufferSize.width, currentViewportSize.width);
+		viewportSize.height = std::min(minBufferSize.height, currentViewportSize.height);
 
 		ConsoleSize bufferSize;
-		bufferSize.width = max(viewportSize.width + 1, minBufferSize.width);
-		bufferSize.height = max(viewportSize.height + 1, minBufferSize.height);
+		bufferSize.width = std::max<uint16_t>(viewportSize.width + 1, minBufferSize.width);
+		bufferSize.height = std::max<uint16_t>(viewportSize.height + 1, minBufferSize.height);
 		_consoleInterface.SetSizes(bufferSize, viewportSize);
 	}
+
+	AddEventListener(this);
 }
 
 FancyGame::~FancyGame()
 {
+	RemoveEventListener(this);
 }
 
 bool FancyGame::Update()
@@ -78,12 +88,19 @@ bool FancyGame::Update()
 		return false;
 	}
 
+	// Let an AI player take its turn before processing input, so that the previous move has already been drawn.
+	if (GetGameStatus() == GameStatus::Active &&
+		IsAIPlayer(GetActivePlayer()))
+	{
+		MarkAIMove(nullptr);
+	}
+
 	_consoleInterface.Update();
 
 	const GameBoard& gameBoard = GetGameBoard();
 	const ConsoleSize minBufferSize = _consoleInterface.GetMinBufferSize();
-	const uint16_t numColumns = minBufferSize.width / CELL_SIZE;
-	const uint16_t numRows = minBufferSize.height / CELL_SIZE;
+	const uint16_t numColumns = gameBoard.GetColumns();
+	const uint16_t numRows = gameBoard.GetRows();
 
 	// If the viewport has been scrolled the game area will need to be redrawn.
 	const ConsoleRect& viewportRect = _consoleInterface.GetCurrentBufferViewportRect();
@@ -104,49 +121,47 @@ bool FancyGame::Update()
 		_isMouseCellMarkerDirty = true;
 	}
 
+	// Erase any temporary marker in the previous mouse cell by repainting it; one is drawn in the current cell below.
+	if (_isMouseCellMarkerDirty && gameBoard.IsValidPosition(_prevMouseCell))
+	{
+		InvalidateCell(_prevMouseCell);
+	}
+
+	UpdateWinHighlight();
+
 	// Draw the game area.
 	if (_isGameAreaDirty)
 	{
 		_consoleInterface.Clear();
 		_isInfoPanelDirty = true;
+		_isMouseCellMarkerDirty = true;
 
-		// If a player has won, highlight the backgrounds of the winning cells.
-		if (GetGameStatus() == GameStatus::Won)
-		{
-			const auto& positionList = gameBoard.GetWinPositionList();
-			for (auto iter = positionList.begin(); iter != positionList.end(); iter++)
-			{
-				ConsoleRect markerRect = sGetMarkerRect(iter->y, iter->x);
-				DrawPlayerMarkerWinBackground(markerRect);
-			}
-		}
-
-		// Draw the current state of every cell in the game board and its borders.
+		// Draw the current state of every visible cell in the game board and its borders.
 		for (uint16_t r = 0; r < numRows; r++)
 		{
 			for (uint16_t c = 0; c < numColumns; c++)
 			{
-				ConsoleRect borderRect = sGetBorderRect(r, c);
-				if (sConsoleRectIntersect(borderRect, viewportRect))
+				if (sConsoleRectIntersect(sGetBorderRect(r, c), viewportRect))
 				{
-					if (c < numColumns - 1)
-					{
-						DrawCellBorderRightSide(borderRect);
-					}
-
-					if (r < numRows - 1)
-					{
-						DrawCellBorderBottomSide(borderRect);
-					}
-
-					ConsoleRect markerRect = sGetMarkerRect(r, c);
-					DrawPlayerMarker(markerRect, gameBoard.GetMarker({ c, r }));
+					DrawCell(r, c);
 				}
 			}
 		}
 
+		_dirtyRects.clear();
 		_isGameAreaDirty = false;
 	}
+	else if (!_dirtyRects.empty())
+	{
+		// Repaint only what has changed. The info panel may overlap the game area, so it's redrawn on top.
+		for (const ConsoleRect& rect : _dirtyRects)
+		{
+			RedrawRect(rect);
+		}
+
+		_dirtyRects.clear();
+		_isInfoPanelDirty = true;
+	}
 
 	// Draw the info panel.
 	if (_isInfoPanelDirty)
@@ -154,7 +169,7 @@ bool FancyGame::Update()
 		static_assert(INFO_AREA_SIZE == 2, "Info panel size is assumed to be 2");
 
 		const ConsoleSize viewportSize = viewportRect.GetSize();
-		uint16_t minWidth = min(minBufferSize.width, viewportSize.width);
+		uint16_t minWidth = std::min(minBufferSize.width, viewportSize.width);
 		uint16_t currentY;
 
 		char buffer[32];
@@ -170,8 +185,9 @@ bool FancyGame::Update()
 
 			// Print the general game information.
 			{
-				bufferCharCount = sprintf_s(
+				bufferCharCount = snprintf(
 					buffer,
+					sizeof(buffer),
 					"%u-in-a-row",
 					gameBoard.GetWinCondition());
 				_consoleInterface.DrawString(
@@ -187,15 +203,16 @@ bool FancyGame::Update()
 				if (_currentMouseCell.x < numColumns &&
 					_currentMouseCell.y < numRows)
 				{
-					bufferCharCount = sprintf_s(
+					bufferCharCount = snprintf(
 						buffer,
+						sizeof(buffer),
 						"(%u, %u)",
 						_currentMouseCell.x,
 						_currentMouseCell.y);
 				}
 				else
 				{
-					bufferCharCount = sprintf_s(buffer, "(-, -)");
+					bufferCharCount = snprintf(buffer, sizeof(buffer), "(-, -)");
 				}
 
 				_consoleInterface.DrawString(
@@ -215,8 +232,9 @@ bool FancyGame::Update()
 			if (GetGameStatus() == GameStatus::Won)
 			{
 				auto winningPlayerID = gameBoard.GetWinningPlayer();
-				bufferCharCount = sprintf_s(
+				bufferCharCount = snprintf(
 					buffer,
+					sizeof(buffer),
 					"-- %s (%c) wins! --",
 					GetPlayerName(winningPlayerID),
 					GetPlayerChar(winningPlayerID));
@@ -225,14 +243,15 @@ bool FancyGame::Update()
 			}
 			else if (GetGameStatus() == GameStatus::Draw)
 			{
-				bufferCharCount = sprintf_s(buffer, "- No spaces left: draw! -");
+				bufferCharCount = snprintf(buffer, sizeof(buffer), "- No spaces left: draw! -");
 				foreground = ConsoleColor::LightGray;
 				background = ConsoleColor::DarkGray;
 			}
 			else
 			{
-				bufferCharCount = sprintf_s(
+				bufferCharCount = snprintf(
 					buffer,
+					sizeof(buffer),
 					"%s's turn (%c)",
 					GetPlayerName(GetActivePlayer()),
 					GetPlayerChar(GetActivePlayer()));
@@ -256,29 +275,21 @@ bool FancyGame::Update()
 		_isInfoPanelDirty = false;
 	}
 
-	// Draw the mouse cell marker.
+	// Draw a temporary marker in the current mouse cell.
 	if (_isMouseCellMarkerDirty)
 	{
-		if (GetGameStatus() == GameStatus::Active)
+		if (GetGameStatus() == GameStatus::Active &&
+			gameBoard.IsValidPosition(_currentMouseCell) &&
+			gameBoard.GetMarker(_currentMouseCell) == kInvalidPlayerID)
 		{
-			// Cleanup any temporary marker in the previous mouse cell.
-			if (gameBoard.IsValidPosition(_prevMouseCell) &&
-				gameBoard.GetMarker(_prevMouseCell) == kInvalidPlayerID)
-			{
-				DrawPlayerMarker(sGetMarkerRect(_prevMouseCell.y, _prevMouseCell.x), GetActivePlayer(), ConsoleColor::Black);
-			}
-
-			// Draw a temporary marker in the current mouse cell.
-			if (gameBoard.IsValidPosition(_currentMouseCell) &&
-				gameBoard.GetMarker(_currentMouseCell) == kInvalidPlayerID)
-			{
-				DrawPlayerMarker(sGetMarkerRect(_currentMouseCell.y, _currentMouseCell.x), GetActivePlayer(), ConsoleColor::DarkGray);
-			}
+			DrawPlayerMarker(sGetMarkerRect(_currentMouseCell.y, _currentMouseCell.x), GetActivePlayer(), ConsoleColor::DarkGray);
 		}
 
 		_isMouseCellMarkerDirty = false;
 	}
 
+	_consoleInterface.Present();
+
 	_prevMouseCell = _currentMouseCell;
 	_prevViewportRect = viewportRect;
 
@@ -296,43 +307,33 @@ void FancyGame::Reset()
 	_isQuitRequested = false;
 }
 
-void FancyGame::OnKeyEvent(const KEY_EVENT_RECORD& event)
+void FancyGame::OnKeyEvent(const ConsoleKeyEvent& event)
 {
-	if (event.bKeyDown)
+	if (event.isKeyDown)
 	{
-		bool isCtrlPressed =
-			event.dwControlKeyState & LEFT_CTRL_PRESSED ||
-			event.dwControlKeyState & RIGHT_CTRL_PRESSED;
+		bool isCtrlPressed = event.isCtrlPressed;
 
-		switch (event.wVirtualKeyCode)
+		switch (event.keyCode)
 		{
-			case VK_SPACE:
+			case kConsoleKeySpace:
 				Reset();
 				break;
 
-			case VK_ESCAPE:
+			case kConsoleKeyEscape:
 				_isQuitRequested = true;
 				break;
 
 			case VK_Y:
 				if (isCtrlPressed)
 				{
-					if (Redo())
-					{
-						_isMouseCellMarkerDirty = true;
-						_isGameAreaDirty = true;
-					}
+					Redo();
 				}
 				break;
 
 			case VK_Z:
 				if (isCtrlPressed)
 				{
-					if (Undo())
-					{
-						_isMouseCellMarkerDirty = true;
-						_isGameAreaDirty = true;
-					}
+					Undo();
 				}
 				break;
 
@@ -343,26 +344,22 @@ void FancyGame::OnKeyEvent(const KEY_EVENT_RECORD& event)
 	}
 }
 
-void FancyGame::OnMouseEvent(const MOUSE_EVENT_RECORD& event)
+void FancyGame::OnMouseEvent(const ConsoleMouseEvent& event)
 {
-	_currentMouseCell = sGetBoardPosition(event.dwMousePosition.X, event.dwMousePosition.Y);
+	_currentMouseCell = sGetBoardPosition(event.position.x, event.position.y);
 
-	if (event.dwButtonState & FROM_LEFT_1ST_BUTTON_PRESSED)
+	if (event.isLeftButtonDown)
 	{
 		if (GetGameStatus() != GameStatus::Active &&
-			event.dwEventFlags & DOUBLE_CLICK)
+			event.type == ConsoleMouseEventType::DoubleClicked)
 		{
 			Reset();
 		}
 
-		if (event.dwEventFlags == 0)
+		if (event.type == ConsoleMouseEventType::ButtonChanged &&
+			!IsAIPlayer(GetActivePlayer()))
 		{
-			MarkResult result = Mark(_currentMouseCell);
-			if (result == MarkResult::Success)
-			{
-				_isGameAreaDirty = true;
-				_isInfoPanelDirty = true;
-			}
+			Mark(_currentMouseCell);
 		}
 	}
 }
@@ -374,6 +371,113 @@ void FancyGame::OnResizeEvent(const ConsoleSize& newSize)
 	_isMouseCellMarkerDirty = true;
 }
 
+void FancyGame::OnGameStarted(const GameBoard& gameBoard)
+{
+	(void)gameBoard;
+	_isGameAreaDirty = true;
+}
+
+void FancyGame::OnMoveApplied(const PlayerMove& move)
+{
+	InvalidateCell(move.position);
+}
+
+void FancyGame::OnMoveReverted(const PlayerMove& move)
+{
+	InvalidateCell(move.position);
+}
+
+void FancyGame::OnSeek(const GameBoard& gameBoard, const std::vector<PlayerMove>& moves, bool isUndo)
+{
+	(void)gameBoard;
+	(void)moves;
+	(void)isUndo;
+
+	// A seek can change any number of cells, so the whole game area is redrawn once rather than cell by cell.
+	_isGameAreaDirty = true;
+}
+
+void FancyGame::InvalidateCell(const BoardPosition& position)
+{
+	InvalidateRect(sGetMarkerRect(position.y, position.x));
+}
+
+void FancyGame::InvalidateRect(const ConsoleRect& rect)
+{
+	// Anything that changes the game area changes the turn shown in the info panel & the temporary marker too.
+	_dirtyRects.push_back(rect);
+	_isInfoPanelDirty = true;
+	_isMouseCellMarkerDirty = true;
+}
+
+// Clears the rect, then redraws every cell it touches. That may draw outside the rect, but only what's already there.
+void FancyGame::RedrawRect(const ConsoleRect& rect)
+{
+	for (uint16_t y = rect.top; y <= rect.bottom; y++)
+	{
+		_consoleInterface.DrawLine(rect.left, y, rect.right, y, ConsoleColor::Black);
+	}
+
+	const GameBoard& gameBoard = GetGameBoard();
+	const BoardPosition topLeft = sGetBoardPosition(rect.left, std::max<uint16_t>(rect.top, INFO_AREA_SIZE));
+	const BoardPosition bottomRight = sGetBoardPosition(rect.right, std::max<uint16_t>(rect.bottom, INFO_AREA_SIZE));
+	for (uint16_t r = topLeft.y; r <= bottomRight.y && r < gameBoard.GetRows(); r++)
+	{
+		for (uint16_t c = topLeft.x; c <= bottomRight.x && c < gameBoard.GetColumns(); c++)
+		{
+			DrawCell(r, c);
+		}
+	}
+}
+
+// Repaints the cells that have started or stopped being part of a win (e.g. after an undo).
+void FancyGame::UpdateWinHighlight()
+{
+	const GameBoard::WinPositionList noCells;
+	const GameBoard::WinPositionList& winCells = (GetGameStatus() == GameStatus::Won) ? GetGameBoard().GetWinPositionList() : noCells;
+	if (std::equal(winCells.begin(), winCells.end(), _highlightedCells.begin(), _highlightedCells.end(),
+		[](const BoardPosition& a, const BoardPosition& b) { return a.x == b.x && a.y == b.y; }))
+	{
+		return;
+	}
+
+	for (const BoardPosition& position : _highlightedCells)
+	{
+		InvalidateCell(position);
+	}
+	for (const BoardPosition& position : winCells)
+	{
+		InvalidateCell(position);
+	}
+	_highlightedCells = winCells;
+}
+
+void FancyGame::DrawCell(uint16_t r, uint16_t c)
+{
+	const GameBoard& gameBoard = GetGameBoard();
+	const ConsoleRect borderRect = sGetBorderRect(r, c);
+	if (c < gameBoard.GetColumns() - 1)
+	{
+		DrawCellBorderRightSide(borderRect);
+	}
+
+	if (r < gameBoard.GetRows() - 1)
+	{
+		DrawCellBorderBottomSide(borderRect);
+	}
+
+	// If a player has won, highlight the backgrounds of the winning cells.
+	const ConsoleRect markerRect = sGetMarkerRect(r, c);
+	const bool isHighlighted = std::any_of(_highlightedCells.begin(), _highlightedCells.end(),
+		[=](const BoardPosition& position) { return position.x == c && position.y == r; });
+	if (isHighlighted)
+	{
+		DrawPlayerMarkerWinBackground(markerRect);
+	}
+
+	DrawPlayerMarker(markerRect, gameBoard.GetMarker({ c, r }));
+}
+
 void FancyGame::DrawCellBorderRightSide(const ConsoleRect& borderRect)
 {
 	_consoleInterface.DrawLine(
@@ -402,6 +506,28 @@ void FancyGame::DrawPlayerMarker(const ConsoleRect& markerRect, PlayerID playerI
 }
 
 void FancyGame::DrawPlayerMarker(const ConsoleRect& markerRect, PlayerID playerID, ConsoleColor color)
+{
+	if (playerID == kInvalidPlayerID)
+	{
+		// Do nothing - empty square.
+		return;
+	}
+
+	// Copy the marker from its sprite, rasterizing that the first time it's needed.
+	const ConsoleSize markerSize = markerRect.GetSize();
+	const uint64_t spriteKey = sGetMarkerSpriteKey(playerID, color, markerSize);
+	auto iter = _markerSprites.find(spriteKey);
+	if (iter == _markerSprites.end())
+	{
+		const ConsoleRect spriteRect = { 0, 0, static_cast<uint16_t>(markerSize.width - 1), static_cast<uint16_t>(markerSize.height - 1) };
+		iter = _markerSprites.emplace(
+			spriteKey,
+			_consoleInterface.RasterizeSprite(markerSize, [&]() { RasterizePlayerMarker(spriteRect, playerID, color); })).first;
+	}
+	_consoleInterface.DrawSprite(iter->second, markerRect.left, markerRect.top);
+}
+
+void FancyGame::RasterizePlayerMarker(const ConsoleRect& markerRect, PlayerID playerID, ConsoleColor color)
 {
 	switch (playerID)
 	{
@@ -433,7 +559,7 @@ void FancyGame::DrawPlayerMarker(const ConsoleRect& markerRect, PlayerID playerI
 			assert(false);
 			break;
 	}
-	static_assert(GameSimulation::kNumPlayers == 2, "FancyGame::DrawPlayerMarker() needs updating.");
+	static_assert(GameSimulation::kNumPlayers == 2, "FancyGame::RasterizePlayerMarker() needs updating.");
 }
 
 void FancyGame::DrawPlayerMarkerWinBackground(const ConsoleRect& markerRect)
@@ -480,3 +606,12 @@ static bool sConsoleRectIntersect(const ConsoleRect& a, const ConsoleRect& b)
 		b.top > a.bottom ||
 		b.bottom < a.top);
 }
+
+static uint64_t sGetMarkerSpriteKey(PlayerID playerID, ConsoleColor color, const ConsoleSize& size)
+{
+	return
+		(static_cast<uint64_t>(playerID) << 40) |
+		(static_cast<uint64_t>(color) << 32) |
+		(static_cast<uint64_t>(size.width) << 16) |
+		static_cast<uint64_t>(size.height);
+}
@@ -1,14 +1,21 @@
 #pragma once
 
 #include "ConsoleInterface.h"
+#include "GameEventListener.h"
 #include "GameSimulation.h"
 
+#include <unordered_map>
+#include <vector>
+
 namespace tictactoe
 {
 	// A fancier text-user-interface (TUI) based implementation of the GameSimulation.
 	// Abuses the console (via ConsoleInterface) to visually render current game state
 	// and allows the user to manipulating that state via mouse cursor and keyboard input.
-	class FancyGame : public GameSimulation
+	//
+	// Listens to its own game events to find which cells a move (or undo) changed, and only repaints those; the
+	// whole game area is only redrawn when the viewport is scrolled or resized, or a new game starts.
+	class FancyGame : public GameSimulation, private GameEventListener
 	{
 	public:
 		static ConsoleColor GetPlayerColor(PlayerID playerID);
@@ -21,24 +28,43 @@ namespace tictactoe
 		virtual void Reset() override;
 
 	private:
-		void OnKeyEvent(const KEY_EVENT_RECORD& event);
-		void OnMouseEvent(const MOUSE_EVENT_RECORD& event);
+		void OnKeyEvent(const ConsoleKeyEvent& event);
+		void OnMouseEvent(const ConsoleMouseEvent& event);
 		void OnResizeEvent(const ConsoleSize& newSize);
 
+		virtual void OnGameStarted(const GameBoard& gameBoard) override;
+		virtual void OnMoveApplied(const PlayerMove& move) override;
+		virtual void OnMoveReverted(const PlayerMove& move) override;
+		virtual void OnSeek(const GameBoard& gameBoard, const std::vector<PlayerMove>& moves, bool isUndo) override;
+
+		void InvalidateCell(const BoardPosition& position);
+		void InvalidateRect(const ConsoleRect& rect);
+		void RedrawRect(const ConsoleRect& rect);
+		void UpdateWinHighlight();
+
+		void DrawCell(uint16_t r, uint16_t c);
 		void DrawCellBorderRightSide(const ConsoleRect& borderRect);
 		void DrawCellBorderBottomSide(const ConsoleRect& borderRect);
 		void DrawPlayerMarker(const ConsoleRect& markerRect, PlayerID playerID);
 		void DrawPlayerMarker(const ConsoleRect& markerRect, PlayerID playerID, ConsoleColor color);
+		void RasterizePlayerMarker(const ConsoleRect& markerRect, PlayerID playerID, ConsoleColor color);
 		void DrawPlayerMarkerWinBackground(const ConsoleRect& markerRect);
 
 	private:
 		ConsoleInterface _consoleInterface;
 
+		// Every player marker drawn so far, keyed by its player, color & size, so that each is only rasterized once.
+		std::unordered_map<uint64_t, ConsoleInterface::Sprite> _markerSprites;
+
 		bool _isGameAreaDirty;
 		bool _isInfoPanelDirty;
 		bool _isMouseCellMarkerDirty;
 		bool _isQuitRequested;
 
+		// What needs repainting (unless the whole game area does), and the cells currently highlighted as a win.
+		std::vector<ConsoleRect> _dirtyRects;
+		std::vector<BoardPosition> _highlightedCells;
+
 		BoardPosition _currentMouseCell;
 		BoardPosition _prevMouseCell;
 		ConsoleRect _prevViewportRect;
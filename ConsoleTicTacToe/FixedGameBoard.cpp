@@ -0,0 +1,20 @@
+#include "FixedGameBoard.h"
+
+using namespace tictactoe;
+
+#define TICTACTOE_DEFINE_FIXED_GAME_BOARD(M, N, K) template class tictactoe::FixedGameBoard<M, N, K>;
+TICTACTOE_FIXED_GAME_BOARD_SIZES(TICTACTOE_DEFINE_FIXED_GAME_BOARD)
+#undef TICTACTOE_DEFINE_FIXED_GAME_BOARD
+
+std::unique_ptr<GameBoard> tictactoe::CreateGameBoard(uint16_t m, uint16_t n, uint16_t k, uint16_t numPlayers)
+{
+#define TICTACTOE_CREATE_FIXED_GAME_BOARD(M, N, K) \
+	if (m == M && n == N && k == K) \
+	{ \
+		return std::make_unique<FixedGameBoard<M, N, K>>(numPlayers); \
+	}
+	TICTACTOE_FIXED_GAME_BOARD_SIZES(TICTACTOE_CREATE_FIXED_GAME_BOARD)
+#undef TICTACTOE_CREATE_FIXED_GAME_BOARD
+
+	return std::make_unique<GameBoard>(m, n, k, numPlayers);
+}
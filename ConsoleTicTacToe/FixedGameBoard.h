@@ -0,0 +1,254 @@
+#pragma once
+
+#include "GameBoard.h"
+
+#include <array>
+#include <memory>
+#include <vector>
+
+// The board sizes that get a FixedGameBoard; every other size uses the dynamically sized GameBoard.
+#define TICTACTOE_FIXED_GAME_BOARD_SIZES(X) \
+	X(3, 3, 3) \
+	X(4, 4, 4) \
+	X(7, 6, 4) \
+	X(15, 15, 5)
+
+namespace tictactoe
+{
+#pragma region FixedWinLines
+
+	// See https://en.wikipedia.org/wiki/Hamming_weight
+	static inline uint32_t sCountBits(uint64_t value)
+	{
+		value = value - ((value >> 1) & 0x5555555555555555ull);
+		value = (value & 0x3333333333333333ull) + ((value >> 2) & 0x3333333333333333ull);
+		value = (value + (value >> 4)) & 0x0F0F0F0F0F0F0F0Full;
+		return static_cast<uint32_t>((value * 0x0101010101010101ull) >> 56);
+	}
+
+	static constexpr uint32_t sGetFixedLineCount(int32_t columns, int32_t rows)
+	{
+		return (columns > 0 && rows > 0) ? static_cast<uint32_t>(columns * rows) : 0;
+	}
+
+	// Every winning line of a M,N,K board as a bit mask over the cells (bit y * M + x), along with the lines that
+	// pass through each cell. Built entirely at compile time by sBuild().
+	template<uint16_t M, uint16_t N, uint16_t K>
+	struct FixedWinLines
+	{
+		static const uint32_t kCellCount = static_cast<uint32_t>(M) * N;
+		static const uint32_t kWordCount = (kCellCount + 63) / 64;
+		static const uint32_t kMaxLinesPerCell = 4 * K;
+
+		static const uint32_t kLineCount =
+			sGetFixedLineCount(M - K + 1, N) +				// '-'
+			sGetFixedLineCount(M, N - K + 1) +				// '|'
+			(2 * sGetFixedLineCount(M - K + 1, N - K + 1));	// '\' & '/'
+
+		// Sized for at least one line so that boards without any (K > M & K > N) still compile.
+		uint64_t lineMasks[(kLineCount > 0) ? kLineCount : 1][kWordCount];
+		uint16_t cellLines[kCellCount][kMaxLinesPerCell];
+		uint8_t cellLineCounts[kCellCount];
+
+		constexpr FixedWinLines() : lineMasks(), cellLines(), cellLineCounts() {}
+
+		static constexpr FixedWinLines sBuild()
+		{
+			struct Offset
+			{
+				int32_t x;
+				int32_t y;
+			};
+			const Offset offsets[4] = { { 1, 0 }, { 0, 1 }, { 1, 1 }, { -1, 1 } };
+
+			FixedWinLines result;
+			uint32_t lineIndex = 0;
+			for (uint32_t i = 0; i < 4; i++)
+			{
+				const Offset offset = offsets[i];
+				for (int32_t y = 0; y < N; y++)
+				{
+					for (int32_t x = 0; x < M; x++)
+					{
+						const int32_t endX = x + ((K - 1) * offset.x);
+						const int32_t endY = y + ((K - 1) * offset.y);
+						if (endX < 0 || endX >= M || endY >= N)
+						{
+							continue;
+						}
+
+						for (int32_t step = 0; step < K; step++)
+						{
+							const uint32_t cell = static_cast<uint32_t>(((y + (step * offset.y)) * M) + x + (step * offset.x));
+							result.lineMasks[lineIndex][cell / 64] |= (uint64_t(1) << (cell % 64));
+							result.cellLines[cell][result.cellLineCounts[cell]++] = static_cast<uint16_t>(lineIndex);
+						}
+						lineIndex++;
+					}
+				}
+			}
+			return result;
+		}
+	};
+
+#pragma endregion
+
+#pragma region FixedGameBoard
+
+	// A GameBoard with compile-time dimensions, which detects wins by testing the precomputed masks of the lines
+	// through the marked cell rather than scanning the board.
+	// Code that is templated on the board type (like the AI players' searches) also gets constant dimensions and
+	// non-virtual Mark() / Unmark() calls; see VisitGameBoard().
+	template<uint16_t M, uint16_t N, uint16_t K>
+	class FixedGameBoard final : public GameBoard
+	{
+	public:
+		typedef FixedWinLines<M, N, K> WinLines;
+
+		explicit FixedGameBoard(uint16_t numPlayers, uint16_t frontierDistance = kDefaultFrontierDistance);
+
+		virtual std::unique_ptr<GameBoard> Clone() const override;
+
+		virtual MarkResult Mark(PlayerID playerID, const BoardPosition& position) override;
+		virtual UnmarkResult Unmark(PlayerID playerID, const BoardPosition& position) override;
+		virtual void Clear() override;
+
+		// Compile-time versions of the GameBoard accessors.
+		static constexpr uint16_t GetColumns() { return M; }
+		static constexpr uint16_t GetRows() { return N; }
+		static constexpr uint16_t GetWinCondition() { return K; }
+		static constexpr uint32_t GetCellCount() { return WinLines::kCellCount; }
+		static constexpr bool IsValidPosition(const BoardPosition& position) { return position.x < M && position.y < N; }
+		static constexpr uint32_t GetCellIndex(const BoardPosition& position) { return (position.y * static_cast<uint32_t>(M)) + position.x; }
+		static constexpr BoardPosition GetCellPosition(uint32_t cellIndex) { return { static_cast<uint16_t>(cellIndex % M), static_cast<uint16_t>(cellIndex / M) }; }
+
+		// Every winning line of the board, and the number of a player's markers on each.
+		static constexpr uint32_t GetLineCount() { return WinLines::kLineCount; }
+		uint32_t CountLineMarkers(uint32_t lineIndex, PlayerID playerID) const;
+
+	private:
+		typedef std::array<uint64_t, WinLines::kWordCount> PlayerMask;
+
+		static constexpr WinLines kWinLines = WinLines::sBuild();
+
+		bool HasWinningLine(const PlayerMask& playerMask, uint32_t cellIndex) const;
+
+		std::vector<PlayerMask> _playerMasks;
+	};
+
+	template<uint16_t M, uint16_t N, uint16_t K>
+	constexpr typename FixedGameBoard<M, N, K>::WinLines FixedGameBoard<M, N, K>::kWinLines;
+
+	template<uint16_t M, uint16_t N, uint16_t K>
+	FixedGameBoard<M, N, K>::FixedGameBoard(uint16_t numPlayers, uint16_t frontierDistance) :
+		GameBoard(M, N, K, numPlayers, frontierDistance),
+		_playerMasks(numPlayers, PlayerMask())
+	{
+	}
+
+	template<uint16_t M, uint16_t N, uint16_t K>
+	std::unique_ptr<GameBoard> FixedGameBoard<M, N, K>::Clone() const
+	{
+		return std::make_unique<FixedGameBoard>(*this);
+	}
+
+	template<uint16_t M, uint16_t N, uint16_t K>
+	MarkResult FixedGameBoard<M, N, K>::Mark(PlayerID playerID, const BoardPosition& position)
+	{
+		const MarkResult result = ValidateMark(playerID, position);
+		if (result == MarkResult::Success)
+		{
+			PlaceMarker(playerID, position);
+
+			const uint32_t cellIndex = GetCellIndex(position);
+			PlayerMask& playerMask = _playerMasks[playerID];
+			playerMask[cellIndex / 64] |= (uint64_t(1) << (cellIndex % 64));
+			if (HasWinningLine(playerMask, cellIndex))
+			{
+				RecordWin(playerID, position);
+			}
+		}
+		return result;
+	}
+
+	template<uint16_t M, uint16_t N, uint16_t K>
+	UnmarkResult FixedGameBoard<M, N, K>::Unmark(PlayerID playerID, const BoardPosition& position)
+	{
+		const UnmarkResult result = GameBoard::Unmark(playerID, position);
+		if (result == UnmarkResult::Success)
+		{
+			const uint32_t cellIndex = GetCellIndex(position);
+			_playerMasks[playerID][cellIndex / 64] &= ~(uint64_t(1) << (cellIndex % 64));
+		}
+		return result;
+	}
+
+	template<uint16_t M, uint16_t N, uint16_t K>
+	void FixedGameBoard<M, N, K>::Clear()
+	{
+		GameBoard::Clear();
+		for (PlayerMask& playerMask : _playerMasks)
+		{
+			playerMask.fill(0);
+		}
+	}
+
+	template<uint16_t M, uint16_t N, uint16_t K>
+	uint32_t FixedGameBoard<M, N, K>::CountLineMarkers(uint32_t lineIndex, PlayerID playerID) const
+	{
+		const PlayerMask& playerMask = _playerMasks[playerID];
+		const uint64_t* lineMask = kWinLines.lineMasks[lineIndex];
+		uint32_t count = 0;
+		for (uint32_t w = 0; w < WinLines::kWordCount; w++)
+		{
+			count += sCountBits(playerMask[w] & lineMask[w]);
+		}
+		return count;
+	}
+
+	template<uint16_t M, uint16_t N, uint16_t K>
+	bool FixedGameBoard<M, N, K>::HasWinningLine(const PlayerMask& playerMask, uint32_t cellIndex) const
+	{
+		for (uint32_t i = 0; i < kWinLines.cellLineCounts[cellIndex]; i++)
+		{
+			const uint64_t* lineMask = kWinLines.lineMasks[kWinLines.cellLines[cellIndex][i]];
+			bool isWin = true;
+			for (uint32_t w = 0; w < WinLines::kWordCount; w++)
+			{
+				isWin &= ((playerMask[w] & lineMask[w]) == lineMask[w]);
+			}
+			if (isWin)
+			{
+				return true;
+			}
+		}
+		return false;
+	}
+
+#define TICTACTOE_DECLARE_FIXED_GAME_BOARD(M, N, K) extern template class FixedGameBoard<M, N, K>;
+	TICTACTOE_FIXED_GAME_BOARD_SIZES(TICTACTOE_DECLARE_FIXED_GAME_BOARD)
+#undef TICTACTOE_DECLARE_FIXED_GAME_BOARD
+
+#pragma endregion
+
+	// Creates a FixedGameBoard if there is one for the given size, otherwise a (dynamically sized) GameBoard.
+	std::unique_ptr<GameBoard> CreateGameBoard(uint16_t m, uint16_t n, uint16_t k, uint16_t numPlayers);
+
+	// Calls visitor(board) with the given board downcast to its FixedGameBoard type if it is one, or as the plain
+	// GameBoard otherwise. Code that is generic over the board type can use this to pick up the fixed board's
+	// compile-time dimensions and non-virtual calls.
+	template<typename Visitor>
+	void VisitGameBoard(GameBoard& gameBoard, Visitor&& visitor)
+	{
+#define TICTACTOE_VISIT_FIXED_GAME_BOARD(M, N, K) \
+		if (auto* fixedGameBoard = dynamic_cast<FixedGameBoard<M, N, K>*>(&gameBoard)) \
+		{ \
+			visitor(*fixedGameBoard); \
+			return; \
+		}
+		TICTACTOE_FIXED_GAME_BOARD_SIZES(TICTACTOE_VISIT_FIXED_GAME_BOARD)
+#undef TICTACTOE_VISIT_FIXED_GAME_BOARD
+
+		visitor(gameBoard);
+	}
+}
@@ -0,0 +1,610 @@
+#include "GameAnalysis.h"
+
+#include "AlphaBetaPlayer.h"
+#include "FixedGameBoard.h"
+#include "GameRecord.h"
+#include "GameSimulation.h"
+#include "MappedFile.h"
+#include "TranspositionTable.h"
+#include "WorkStealingPool.h"
+
+#include <algorithm>
+#include <chrono>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <dirent.h>
+#include <sys/stat.h>
+#endif
+
+using namespace tictactoe;
+
+static const uint32_t kAnalysisTranspositionTableSizeMB = 16;
+
+// Records are handed out to the threads in batches of this many, so that the games of one large file are still
+// shared between them.
+static const uint32_t kGamesPerTask = 64;
+
+// Each thread's results are written out once they reach this size (and when it's done).
+static const size_t kOutputFlushSize = 64 * 1024;
+
+// A position's proven result from player 1's perspective, ordered so that higher is better for player 1.
+enum class Outcome : int8_t
+{
+	Loss = -1,
+	Draw = 0,
+	Win = 1,
+	Unknown = 2
+};
+
+// The engine's view of one position of a game, from player 1's perspective.
+struct PositionEval
+{
+	int32_t score;
+	Outcome outcome;
+	uint32_t bestMove;	// TranspositionTable::kNoMove once the game is over.
+};
+
+// A contiguous batch of records in one file.
+struct AnalysisTask
+{
+	uint32_t fileIndex;
+	uint64_t firstGameNumber;
+	size_t offset;
+	uint32_t gameCount;
+};
+
+// The state owned by each thread, reused from game to game.
+struct AnalysisWorker
+{
+	std::unique_ptr<AlphaBetaPlayer> player;
+	std::unique_ptr<GameBoard> gameBoard;
+	MappedFile file;
+	uint32_t fileIndex;
+
+	std::vector<uint32_t> moves;
+	std::vector<PositionEval> positions;
+	std::string output;
+
+	uint64_t gameCount;
+	uint64_t moveCount;
+	uint64_t blunderCount;
+};
+
+static bool sListFiles(const std::string& directoryPath, std::vector<std::string>* outFileNames);
+static std::string sGetFilePath(const std::string& directoryPath, const std::string& fileName);
+static bool sAnalyzeGame(AnalysisWorker& worker, const GameRecord& record);
+static PositionEval sEvaluatePosition(AnalysisWorker& worker, PlayerID playerID);
+static bool sIsBlunder(const AnalysisWorker& worker, size_t moveIndex);
+static int64_t sGetDecidedMove(const AnalysisWorker& worker);
+static const char* sGetOutcomeString(Outcome outcome);
+static void sAppendCsvScore(std::string& output, int32_t score);
+static void sAppendJsonScore(std::string& output, const char* scoreName, const char* mateName, int32_t score);
+static void sAppendCsvHeader(std::string& output);
+static void sAppendCsvRows(std::string& output, const AnalysisWorker& worker, const GameRecord& record, const std::string& fileName, uint64_t gameNumber);
+static void sAppendJsonLine(std::string& output, const AnalysisWorker& worker, const GameRecord& record, const std::string& fileName, uint64_t gameNumber);
+static void sAppendCsvString(std::string& output, const std::string& str);
+static void sAppendJsonString(std::string& output, const std::string& str);
+
+bool tictactoe::RunGameAnalysis(
+	const char* directoryPath, AnalysisFormat format, uint16_t threadCount, uint32_t moveTimeMs,
+	const Tablebase* tablebase, std::ostream& output)
+{
+	std::vector<std::string> fileNames;
+	if (!sListFiles(directoryPath, &fileNames))
+	{
+		return false;
+	}
+
+	// Split every file into batches up front; this only reads the records' varints, and keeps just their offsets.
+	const auto startTime = std::chrono::steady_clock::now();
+	std::vector<AnalysisTask> tasks;
+	for (uint32_t fileIndex = 0; fileIndex < fileNames.size(); fileIndex++)
+	{
+		MappedFile file;
+		if (!file.Open(sGetFilePath(directoryPath, fileNames[fileIndex]).c_str()))
+		{
+			std::cerr << "Skipping '" << fileNames[fileIndex] << "': unable to open it." << std::endl;
+			continue;
+		}
+
+		GameRecordReader reader(file.GetData(), file.GetSize());
+		if (!reader.IsValid())
+		{
+			std::cerr << "Skipping '" << fileNames[fileIndex] << "': not a game record file." << std::endl;
+			continue;
+		}
+
+		GameRecord record;
+		AnalysisTask task = { fileIndex, 1, reader.GetOffset(), 0 };
+		for (uint64_t gameNumber = 1; ; gameNumber++)
+		{
+			const size_t offset = reader.GetOffset();
+			if (!reader.ReadNext(&record))
+			{
+				break;
+			}
+			if (task.gameCount == kGamesPerTask)
+			{
+				tasks.push_back(task);
+				task = { fileIndex, gameNumber, offset, 0 };
+			}
+			task.gameCount++;
+		}
+		if (task.gameCount > 0)
+		{
+			tasks.push_back(task);
+		}
+
+		if (!reader.IsValid())
+		{
+			std::cerr << "Warning: '" << fileNames[fileIndex] << "' ends with a malformed record." << std::endl;
+		}
+	}
+
+	std::unique_ptr<AnalysisWorker[]> workers(new AnalysisWorker[threadCount]);
+	for (uint16_t i = 0; i < threadCount; i++)
+	{
+		workers[i].player = std::make_unique<AlphaBetaPlayer>(moveTimeMs, kAnalysisTranspositionTableSizeMB, 1);
+		workers[i].player->SetTablebase(tablebase);
+		workers[i].fileIndex = UINT32_MAX;
+		workers[i].gameCount = 0;
+		workers[i].moveCount = 0;
+		workers[i].blunderCount = 0;
+	}
+
+	std::mutex outputMutex;
+	auto flushOutput = [&output, &outputMutex](AnalysisWorker& worker)
+	{
+		std::lock_guard<std::mutex> lock(outputMutex);
+		output.write(worker.output.data(), worker.output.size());
+		worker.output.clear();
+	};
+
+	if (format == AnalysisFormat::Csv)
+	{
+		std::string header;
+		sAppendCsvHeader(header);
+		output << header;
+	}
+
+	WorkStealingPool pool(threadCount);
+	pool.Run(tasks.size(), [&](uint16_t workerIndex, uint64_t taskIndex)
+	{
+		AnalysisWorker& worker = workers[workerIndex];
+		const AnalysisTask& task = tasks[taskIndex];
+		const std::string& fileName = fileNames[task.fileIndex];
+
+		// Consecutive batches usually come from the same file, which then stays mapped.
+		if (worker.fileIndex != task.fileIndex)
+		{
+			worker.file.Open(sGetFilePath(directoryPath, fileName).c_str());
+			worker.fileIndex = task.fileIndex;
+		}
+		if (!worker.file.IsOpen())
+		{
+			return;
+		}
+
+		GameRecordReader reader(worker.file.GetData(), worker.file.GetSize());
+		reader.Seek(task.offset);
+
+		GameRecord record;
+		for (uint32_t i = 0; i < task.gameCount && reader.ReadNext(&record); i++)
+		{
+			if (!sAnalyzeGame(worker, record))
+			{
+				continue;
+			}
+
+			if (format == AnalysisFormat::Json)
+			{
+				sAppendJsonLine(worker.output, worker, record, fileName, task.firstGameNumber + i);
+			}
+			else
+			{
+				sAppendCsvRows(worker.output, worker, record, fileName, task.firstGameNumber + i);
+			}
+			if (worker.output.size() >= kOutputFlushSize)
+			{
+				flushOutput(worker);
+			}
+		}
+	});
+
+	uint64_t gameCount = 0;
+	uint64_t moveCount = 0;
+	uint64_t blunderCount = 0;
+	for (uint16_t i = 0; i < threadCount; i++)
+	{
+		flushOutput(workers[i]);
+		gameCount += workers[i].gameCount;
+		moveCount += workers[i].moveCount;
+		blunderCount += workers[i].blunderCount;
+	}
+	output.flush();
+
+	// The results may be going to stdout, so the summary goes to stderr.
+	const double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - startTime).count();
+	std::cerr
+		<< "Analyzed " << gameCount << (gameCount == 1 ? " game (" : " games (")
+		<< moveCount << (moveCount == 1 ? " move, " : " moves, ")
+		<< blunderCount << (blunderCount == 1 ? " blunder) from " : " blunders) from ")
+		<< fileNames.size() << (fileNames.size() == 1 ? " file on " : " files on ")
+		<< threadCount << (threadCount == 1 ? " thread in " : " threads in ")
+		<< std::fixed << std::setprecision(2) << seconds << " seconds." << std::endl;
+	return true;
+}
+
+#ifdef _WIN32
+
+static bool sListFiles(const std::string& directoryPath, std::vector<std::string>* outFileNames)
+{
+	outFileNames->clear();
+
+	WIN32_FIND_DATAA findData;
+	HANDLE findHandle = FindFirstFileA(sGetFilePath(directoryPath, "*").c_str(), &findData);
+	if (findHandle == INVALID_HANDLE_VALUE)
+	{
+		return GetLastError() == ERROR_FILE_NOT_FOUND;
+	}
+
+	do
+	{
+		if ((findData.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY) == 0)
+		{
+			outFileNames->push_back(findData.cFileName);
+		}
+	} while (FindNextFileA(findHandle, &findData));
+	FindClose(findHandle);
+
+	std::sort(outFileNames->begin(), outFileNames->end());
+	return true;
+}
+
+static std::string sGetFilePath(const std::string& directoryPath, const std::string& fileName)
+{
+	return directoryPath + "\\" + fileName;
+}
+
+#else
+
+static bool sListFiles(const std::string& directoryPath, std::vector<std::string>* outFileNames)
+{
+	outFileNames->clear();
+
+	DIR* directory = opendir(directoryPath.c_str());
+	if (directory == nullptr)
+	{
+		return false;
+	}
+
+	while (const dirent* entry = readdir(directory))
+	{
+		struct stat fileStat;
+		if (stat(sGetFilePath(directoryPath, entry->d_name).c_str(), &fileStat) == 0 && S_ISREG(fileStat.st_mode))
+		{
+			outFileNames->push_back(entry->d_name);
+		}
+	}
+	closedir(directory);
+
+	std::sort(outFileNames->begin(), outFileNames->end());
+	return true;
+}
+
+static std::string sGetFilePath(const std::string& directoryPath, const std::string& fileName)
+{
+	return directoryPath + "/" + fileName;
+}
+
+#endif
+
+static bool sAnalyzeGame(AnalysisWorker& worker, const GameRecord& record)
+{
+	// The engine only plays 2-player games.
+	if (record.numPlayers != GameSimulation::kNumPlayers)
+	{
+		return false;
+	}
+
+	GameRecordReader::ReadFinalLine(record, &worker.moves);
+	if (worker.moves.empty())
+	{
+		return false;
+	}
+
+	if (worker.gameBoard == nullptr ||
+		worker.gameBoard->GetColumns() != record.columns ||
+		worker.gameBoard->GetRows() != record.rows ||
+		worker.gameBoard->GetWinCondition() != record.winCondition)
+	{
+		worker.gameBoard = CreateGameBoard(record.columns, record.rows, record.winCondition, GameSimulation::kNumPlayers);
+	}
+	else
+	{
+		worker.gameBoard->Clear();
+	}
+
+	// Evaluate every position of the game, including the final one. A move that can't be played (e.g. one after
+	// the game was already won) ends the game there.
+	GameBoard& gameBoard = *worker.gameBoard;
+	worker.positions.clear();
+	PlayerID playerID = 0;
+	for (size_t moveIndex = 0; ; moveIndex++)
+	{
+		worker.positions.push_back(sEvaluatePosition(worker, playerID));
+		if (moveIndex == worker.moves.size() || worker.positions.back().bestMove == TranspositionTable::kNoMove)
+		{
+			break;
+		}
+
+		const uint32_t move = worker.moves[moveIndex];
+		if (move >= gameBoard.GetCellCount() || gameBoard.Mark(playerID, gameBoard.GetCellPosition(move)) != MarkResult::Success)
+		{
+			break;
+		}
+		playerID = (playerID + 1) % GameSimulation::kNumPlayers;
+	}
+	worker.moves.resize(worker.positions.size() - 1);
+
+	worker.gameCount++;
+	worker.moveCount += worker.moves.size();
+	for (size_t moveIndex = 0; moveIndex < worker.moves.size(); moveIndex++)
+	{
+		worker.blunderCount += sIsBlunder(worker, moveIndex) ? 1 : 0;
+	}
+	return true;
+}
+
+static PositionEval sEvaluatePosition(AnalysisWorker& worker, PlayerID playerID)
+{
+	GameBoard& gameBoard = *worker.gameBoard;
+	const PlayerID winningPlayer = gameBoard.GetWinningPlayer();
+	if (winningPlayer != kInvalidPlayerID)
+	{
+		return (winningPlayer == 0) ?
+			PositionEval{ AlphaBetaPlayer::kWinScore, Outcome::Win, TranspositionTable::kNoMove } :
+			PositionEval{ -AlphaBetaPlayer::kWinScore, Outcome::Loss, TranspositionTable::kNoMove };
+	}
+	if (gameBoard.IsFilled())
+	{
+		return { 0, Outcome::Draw, TranspositionTable::kNoMove };
+	}
+
+	const BoardPosition bestMove = worker.player->ChooseMove(gameBoard, playerID);
+	const AlphaBetaPlayer::SearchStats& stats = worker.player->GetLastSearchStats();
+
+	PositionEval position = { stats.score, Outcome::Unknown, gameBoard.GetCellIndex(bestMove) };
+	if (AlphaBetaPlayer::IsWinningScore(stats.score))
+	{
+		position.outcome = Outcome::Win;
+	}
+	else if (AlphaBetaPlayer::IsLosingScore(stats.score))
+	{
+		position.outcome = Outcome::Loss;
+	}
+	else if (stats.isSolved)
+	{
+		position.outcome = Outcome::Draw;
+	}
+
+	// The search scores the position for the player to move.
+	if (playerID != 0)
+	{
+		position.score = -position.score;
+		if (position.outcome != Outcome::Unknown)
+		{
+			position.outcome = static_cast<Outcome>(-static_cast<int8_t>(position.outcome));
+		}
+	}
+	return position;
+}
+
+static bool sIsBlunder(const AnalysisWorker& worker, size_t moveIndex)
+{
+	const Outcome before = worker.positions[moveIndex].outcome;
+	const Outcome after = worker.positions[moveIndex + 1].outcome;
+	if (before == Outcome::Unknown || after == Outcome::Unknown)
+	{
+		return false;
+	}
+
+	// Outcomes are from player 1's perspective, so player 2 blunders by making them better.
+	return (moveIndex % GameSimulation::kNumPlayers == 0) ? (after < before) : (after > before);
+}
+
+// The number of moves after which the game's result was proven and never changed (0 if it was from the start),
+// or -1 if the final position's result isn't known.
+static int64_t sGetDecidedMove(const AnalysisWorker& worker)
+{
+	const Outcome result = worker.positions.back().outcome;
+	if (result == Outcome::Unknown)
+	{
+		return -1;
+	}
+
+	size_t moveIndex = worker.positions.size() - 1;
+	while (moveIndex > 0 && worker.positions[moveIndex - 1].outcome == result)
+	{
+		moveIndex--;
+	}
+	return static_cast<int64_t>(moveIndex);
+}
+
+// The same notation as WriteGameRecordText().
+static const char* sGetOutcomeString(Outcome outcome)
+{
+	switch (outcome)
+	{
+		case Outcome::Win:	return "1-0";
+		case Outcome::Loss:	return "0-1";
+		case Outcome::Draw:	return "1/2-1/2";
+		default:			return "*";
+	}
+}
+
+// A proven score is kWinScore less the number of plies to the win, so it's written out as that distance instead
+// (negative if player 2 wins), and only heuristic scores are written as scores. The other field is left empty.
+static void sAppendCsvScore(std::string& output, int32_t score)
+{
+	if (AlphaBetaPlayer::IsWinningScore(score))
+	{
+		output += ",," + std::to_string(AlphaBetaPlayer::kWinScore - score);
+	}
+	else if (AlphaBetaPlayer::IsLosingScore(score))
+	{
+		output += ",," + std::to_string(-AlphaBetaPlayer::kWinScore - score);
+	}
+	else
+	{
+		output += ',' + std::to_string(score) + ',';
+	}
+}
+
+// As above, with the other field null.
+static void sAppendJsonScore(std::string& output, const char* scoreName, const char* mateName, int32_t score)
+{
+	std::string scoreValue = "null";
+	std::string mateValue = "null";
+	if (AlphaBetaPlayer::IsWinningScore(score))
+	{
+		mateValue = std::to_string(AlphaBetaPlayer::kWinScore - score);
+	}
+	else if (AlphaBetaPlayer::IsLosingScore(score))
+	{
+		mateValue = std::to_string(-AlphaBetaPlayer::kWinScore - score);
+	}
+	else
+	{
+		scoreValue = std::to_string(score);
+	}
+
+	output += ",\"";
+	output += scoreName;
+	output += "\":" + scoreValue + ",\"";
+	output += mateName;
+	output += "\":" + mateValue;
+}
+
+static void sAppendCsvHeader(std::string& output)
+{
+	output += "file,game,move,player,x,y,eval,mate_in,outcome,best_x,best_y,best_eval,best_mate_in,blunder,result,decided_at\n";
+}
+
+static void sAppendCsvRows(std::string& output, const AnalysisWorker& worker, const GameRecord& record, const std::string& fileName, uint64_t gameNumber)
+{
+	const int64_t decidedMove = sGetDecidedMove(worker);
+	const char* result = sGetOutcomeString(worker.positions.back().outcome);
+	for (size_t moveIndex = 0; moveIndex < worker.moves.size(); moveIndex++)
+	{
+		const PositionEval& before = worker.positions[moveIndex];
+		const PositionEval& after = worker.positions[moveIndex + 1];
+		const uint32_t move = worker.moves[moveIndex];
+
+		sAppendCsvString(output, fileName);
+		output += ',' + std::to_string(gameNumber);
+		output += ',' + std::to_string(moveIndex + 1);
+		output += ',';
+		output += GameSimulation::GetPlayerChar(static_cast<PlayerID>(moveIndex % GameSimulation::kNumPlayers));
+		output += ',' + std::to_string(move % record.columns);
+		output += ',' + std::to_string(move / record.columns);
+		sAppendCsvScore(output, after.score);
+		output += ',';
+		output += sGetOutcomeString(after.outcome);
+		output += ',' + std::to_string(before.bestMove % record.columns);
+		output += ',' + std::to_string(before.bestMove / record.columns);
+		sAppendCsvScore(output, before.score);
+		output += sIsBlunder(worker, moveIndex) ? ",1," : ",0,";
+		output += result;
+		output += ',';
+		if (decidedMove >= 0)
+		{
+			output += std::to_string(decidedMove);
+		}
+		output += '\n';
+	}
+}
+
+static void sAppendJsonLine(std::string& output, const AnalysisWorker& worker, const GameRecord& record, const std::string& fileName, uint64_t gameNumber)
+{
+	const int64_t decidedMove = sGetDecidedMove(worker);
+
+	output += "{\"file\":";
+	sAppendJsonString(output, fileName);
+	output += ",\"game\":" + std::to_string(gameNumber);
+	output += ",\"board\":\"" + std::to_string(record.columns) + "x" + std::to_string(record.rows) + "\"";
+	output += ",\"winCondition\":" + std::to_string(record.winCondition);
+	output += ",\"result\":\"";
+	output += sGetOutcomeString(worker.positions.back().outcome);
+	output += "\",\"decidedAt\":";
+	output += (decidedMove >= 0) ? std::to_string(decidedMove) : "null";
+	output += ",\"moves\":[";
+	for (size_t moveIndex = 0; moveIndex < worker.moves.size(); moveIndex++)
+	{
+		const PositionEval& before = worker.positions[moveIndex];
+		const PositionEval& after = worker.positions[moveIndex + 1];
+		const uint32_t move = worker.moves[moveIndex];
+
+		output += (moveIndex > 0) ? ",{" : "{";
+		output += "\"player\":\"";
+		output += GameSimulation::GetPlayerChar(static_cast<PlayerID>(moveIndex % GameSimulation::kNumPlayers));
+		output += "\",\"x\":" + std::to_string(move % record.columns);
+		output += ",\"y\":" + std::to_string(move / record.columns);
+		sAppendJsonScore(output, "eval", "mateIn", after.score);
+		output += ",\"outcome\":\"";
+		output += sGetOutcomeString(after.outcome);
+		output += "\",\"bestX\":" + std::to_string(before.bestMove % record.columns);
+		output += ",\"bestY\":" + std::to_string(before.bestMove / record.columns);
+		sAppendJsonScore(output, "bestEval", "bestMateIn", before.score);
+		output += sIsBlunder(worker, moveIndex) ? ",\"blunder\":true}" : ",\"blunder\":false}";
+	}
+	output += "]}\n";
+}
+
+static void sAppendCsvString(std::string& output, const std::string& str)
+{
+	output += '"';
+	for (char c : str)
+	{
+		output += c;
+		if (c == '"')
+		{
+			output += '"';
+		}
+	}
+	output += '"';
+}
+
+static void sAppendJsonString(std::string& output, const std::string& str)
+{
+	static const char kHexDigits[] = "0123456789abcdef";
+
+	output += '"';
+	for (char c : str)
+	{
+		if (c == '"' || c == '\\')
+		{
+			output += '\\';
+			output += c;
+		}
+		else if (static_cast<unsigned char>(c) < 0x20)
+		{
+			output += "\\u00";
+			output += kHexDigits[(c >> 4) & 0xF];
+			output += kHexDigits[c & 0xF];
+		}
+		else
+		{
+			output += c;
+		}
+	}
+	output += '"';
+}
@@ -0,0 +1,33 @@
+#pragma once
+
+#include <cstdint>
+#include <iosfwd>
+
+namespace tictactoe
+{
+	class Tablebase;
+
+	enum class AnalysisFormat
+	{
+		Csv = 0,
+		Json,
+
+		Count
+	};
+
+	// Annotates every game in the record files (see GameRecordWriter) of the given directory, searching each
+	// position of its final line with an AlphaBetaPlayer for up to moveTimeMs. For every move this gives the
+	// engine's evaluation before & after it, its best move, and whether the move was a blunder (one that turned a
+	// proven win into a draw or loss, or a draw into a loss); for every game, the first move after which its result
+	// was proven and stayed that way. Evaluations are from player 1's perspective; a proven one is given as the
+	// number of plies to the win instead (negative if player 2 wins).
+	//
+	// The files are mapped and split into batches of records by offset, so a corpus is never loaded all at once;
+	// the batches are run on a WorkStealingPool with threadCount threads and the results are streamed to output as
+	// they're finished (in CSV, one row per move, or JSON Lines, one object per game), so they aren't in file order.
+	// Positions of games the size of the (optional) tablebase are looked up in it instead of searched.
+	// Returns false if the directory can't be read.
+	bool RunGameAnalysis(
+		const char* directoryPath, AnalysisFormat format, uint16_t threadCount, uint32_t moveTimeMs,
+		const Tablebase* tablebase, std::ostream& output);
+}
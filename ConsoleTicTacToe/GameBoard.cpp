@@ -1,9 +1,14 @@
 #include "GameBoard.h"
 
+#include <algorithm>
 #include <cassert>
+#include <cstdlib>
+#include <cstring>
 
 using namespace tictactoe;
 
+static const uint32_t kCacheLineSize = 64;
+
 static constexpr bool sInRangeArray(uint16_t val, uint16_t min, uint16_t max)
 {
 	return (min <= val && val < max);
@@ -14,69 +19,167 @@ static constexpr bool sInRangeGrid(const BoardPosition& position, uint16_t colum
 	return (sInRangeArray(position.x, 0, columns) && sInRangeArray(position.y, 0, rows));
 }
 
-GameBoard::GameBoard(uint16_t columns, uint16_t rows, uint16_t winCondition) :
+struct Offset
+{
+	int16_t x;
+	int16_t y;
+};
+
+static const Offset kWinOffsets[4] =
+{
+	{ -1,  1 },	// '/' - forward slash
+	{ -1,  0 }, // '-' - horizontal
+	{ -1, -1 },	// '\' - backslash
+	{  0, -1 },	// '|' - vertical
+};
+
+// Maps the upper 32 random bits onto [0, count) with a multiply rather than a (slower, biased) modulo.
+static uint32_t sGetRandomIndex(uint64_t random, uint32_t count)
+{
+	return static_cast<uint32_t>(((random >> 32) * count) >> 32);
+}
+
+GameBoard::GameBoard(
+	uint16_t columns, uint16_t rows, uint16_t winCondition, uint16_t numPlayers,
+	uint16_t frontierDistance) :
 	_columns(columns),
 	_rows(rows),
 	_winCondition(winCondition),
-	_grid(nullptr),
+	_cellAllocation(nullptr),
+	_cells(nullptr),
+	_rowStride(0),
+	_generation(1),
 	_markerCount(0),
+	_freeCells(GetCellCount()),
+	_freeCellSlots(GetCellCount()),
+	_frontierDistance(frontierDistance),
+	_frontierCounts((frontierDistance > 0) ? GetCellCount() : 0, FrontierCount{ 0, 0 }),
+	_frontierCells((frontierDistance > 0) ? GetCellCount() : 0),
+	_frontierSlots((frontierDistance > 0) ? GetCellCount() : 0),
+	_frontierCellCount(0),
+	_playerBoards(numPlayers, BitBoard(columns, rows)),
+	_zobristTable(std::make_shared<ZobristTable>(columns, rows, numPlayers)),
+	_symmetryHashes(),
 	_winningPlayerID(kInvalidPlayerID),
 	_winningPositions()
 {
-	_grid = new PlayerID*[_rows];
-	for (uint16_t row = 0; row < _rows; row++)
+	// Keeps every per-cell frontier count below (2 * 127 + 1)^2, which fits in 16 bits.
+	assert(frontierDistance <= 127);
+
+	AllocateCells();
+
+	for (uint32_t cellIndex = 0; cellIndex < GetCellCount(); cellIndex++)
 	{
-		_grid[row] = new PlayerID[_columns];
-		for (uint16_t column = 0; column < _columns; column++)
-		{
-			_grid[row][column] = kInvalidPlayerID;
-		}
+		_freeCells[cellIndex] = cellIndex;
+		_freeCellSlots[cellIndex] = cellIndex;
 	}
 }
 
-GameBoard::~GameBoard()
+GameBoard::GameBoard(const GameBoard& other) :
+	_columns(other._columns),
+	_rows(other._rows),
+	_winCondition(other._winCondition),
+	_cellAllocation(nullptr),
+	_cells(nullptr),
+	_rowStride(0),
+	_generation(other._generation),
+	_markerCount(other._markerCount),
+	_freeCells(other._freeCells),
+	_freeCellSlots(other._freeCellSlots),
+	_frontierDistance(other._frontierDistance),
+	_frontierCounts(other._frontierCounts),
+	_frontierCells(other._frontierCells),
+	_frontierSlots(other._frontierSlots),
+	_frontierCellCount(other._frontierCellCount),
+	_playerBoards(other._playerBoards),
+	_zobristTable(other._zobristTable),
+	_symmetryHashes(),
+	_winningPlayerID(other._winningPlayerID),
+	_winningPositions(other._winningPositions)
+{
+	AllocateCells();
+	memcpy(_cells, other._cells, sizeof(Cell) * _rowStride * _rows);
+	memcpy(_symmetryHashes, other._symmetryHashes, sizeof(_symmetryHashes));
+}
+
+GameBoard& GameBoard::operator=(const GameBoard& other)
 {
-	if (_grid != nullptr)
+	if (this != &other)
 	{
-		for (uint16_t row = 0; row < _rows; row++)
+		if (_columns != other._columns || _rows != other._rows)
 		{
-			delete[] _grid[row];
+			FreeCells();
+			_columns = other._columns;
+			_rows = other._rows;
+			AllocateCells();
 		}
-		delete[] _grid;
-		_grid = nullptr;
+		memcpy(_cells, other._cells, sizeof(Cell) * _rowStride * _rows);
+
+		_winCondition = other._winCondition;
+		_generation = other._generation;
+		_markerCount = other._markerCount;
+		_freeCells = other._freeCells;
+		_freeCellSlots = other._freeCellSlots;
+		_frontierDistance = other._frontierDistance;
+		_frontierCounts = other._frontierCounts;
+		_frontierCells = other._frontierCells;
+		_frontierSlots = other._frontierSlots;
+		_frontierCellCount = other._frontierCellCount;
+		_playerBoards = other._playerBoards;
+		_zobristTable = other._zobristTable;
+		memcpy(_symmetryHashes, other._symmetryHashes, sizeof(_symmetryHashes));
+		_winningPlayerID = other._winningPlayerID;
+		_winningPositions = other._winningPositions;
 	}
+	return *this;
 }
 
-MarkResult GameBoard::Mark(PlayerID playerID, const BoardPosition& position)
+GameBoard::~GameBoard()
 {
-	assert(playerID != kInvalidPlayerID);
+	FreeCells();
+}
 
-	MarkResult result;
-	if (_winningPlayerID != kInvalidPlayerID)
-	{
-		result = MarkResult::GameAlreadyOver;
-	}
-	else if (!IsValidPosition(position))
-	{
-		result = MarkResult::PositionOutOfBounds;
-	}
-	else if (GetMarker(position) != kInvalidPlayerID)
-	{
-		result = MarkResult::PositionAlreadyMarked;
-	}
-	else
+void GameBoard::AllocateCells()
+{
+	assert(_cellAllocation == nullptr);
+
+	// Zeroed memory reads as generation 0 (which is never current) so no cell needs to be touched up front;
+	// calloc can also hand back untouched zero pages for large boards.
+	const uint32_t cellsPerCacheLine = kCacheLineSize / sizeof(Cell);
+	_rowStride = ((_columns + cellsPerCacheLine - 1) / cellsPerCacheLine) * cellsPerCacheLine;
+	_cellAllocation = calloc(static_cast<size_t>(_rowStride) * _rows * sizeof(Cell) + kCacheLineSize - 1, 1);
+	assert(_cellAllocation != nullptr);
+
+	const uintptr_t address = reinterpret_cast<uintptr_t>(_cellAllocation);
+	_cells = reinterpret_cast<Cell*>((address + kCacheLineSize - 1) & ~static_cast<uintptr_t>(kCacheLineSize - 1));
+}
+
+void GameBoard::FreeCells()
+{
+	free(_cellAllocation);
+	_cellAllocation = nullptr;
+	_cells = nullptr;
+}
+
+std::unique_ptr<GameBoard> GameBoard::Clone() const
+{
+	return std::make_unique<GameBoard>(*this);
+}
+
+MarkResult GameBoard::Mark(PlayerID playerID, const BoardPosition& position)
+{
+	const MarkResult result = ValidateMark(playerID, position);
+	if (result == MarkResult::Success)
 	{
-		_grid[position.y][position.x] = playerID;
-		_markerCount++;
+		PlaceMarker(playerID, position);
 		CheckForWin(playerID, position);
-		result = MarkResult::Success;
 	}
 	return result;
 }
 
 UnmarkResult GameBoard::Unmark(PlayerID playerID, const BoardPosition& position)
 {
-	assert(playerID != kInvalidPlayerID);
+	assert(playerID < GetNumPlayers());
 
 	UnmarkResult result;
 	if (!IsValidPosition(position))
@@ -89,8 +192,13 @@ UnmarkResult GameBoard::Unmark(PlayerID playerID, const BoardPosition& position)
 	}
 	else
 	{
-		_grid[position.y][position.x] = kInvalidPlayerID;
+		const uint32_t cellIndex = GetCellIndex(position);
+		GetCell(position).playerID = kInvalidPlayerID;
+		_playerBoards[playerID].Reset(position.x, position.y);
+		UpdateSymmetryHashes(playerID, position);
 		_markerCount--;
+		MoveToFreeCellSlot(cellIndex, GetFreeCellCount() - 1);
+		UpdateFrontier(position, false);
 		ClearWin();
 		result = UnmarkResult::Success;
 	}
@@ -99,14 +207,23 @@ UnmarkResult GameBoard::Unmark(PlayerID playerID, const BoardPosition& position)
 
 void GameBoard::Clear()
 {
-	for (uint16_t row = 0; row < _rows; row++)
+	// Advancing the generation invalidates every cell at once; only when it wraps around does the grid
+	// actually need to be wiped.
+	_generation++;
+	if (_generation == 0)
 	{
-		for (uint16_t column = 0; column < _columns; column++)
-		{
-			_grid[row][column] = kInvalidPlayerID;
-		}
+		memset(_cells, 0, sizeof(Cell) * _rowStride * _rows);
+		std::fill(_frontierCounts.begin(), _frontierCounts.end(), FrontierCount{ 0, 0 });
+		_generation = 1;
 	}
 	_markerCount = 0;
+	_frontierCellCount = 0;	// Every cell is already in the free cell list, so this also frees them all.
+	memset(_symmetryHashes, 0, sizeof(_symmetryHashes));
+
+	for (auto& playerBoard : _playerBoards)
+	{
+		playerBoard.Clear();
+	}
 
 	ClearWin();
 }
@@ -119,34 +236,232 @@ bool GameBoard::IsValidPosition(const BoardPosition& position) const
 PlayerID GameBoard::GetMarker(const BoardPosition& position) const
 {
 	assert(IsValidPosition(position));
-	return _grid[position.y][position.x];
+	const Cell& cell = GetCell(position);
+	return (cell.generation == _generation) ? cell.playerID : kInvalidPlayerID;
+}
+
+BoardSymmetry GameBoard::GetCanonicalSymmetry() const
+{
+	uint16_t canonical = 0;
+	for (uint16_t i = 1; i < GetSymmetryCount(); i++)
+	{
+		if (_symmetryHashes[i] < _symmetryHashes[canonical])
+		{
+			canonical = i;
+		}
+	}
+	return static_cast<BoardSymmetry>(canonical);
+}
+
+BoardPosition GameBoard::TransformPosition(const BoardPosition& position, BoardSymmetry symmetry) const
+{
+	assert(static_cast<uint16_t>(symmetry) < GetSymmetryCount());
+
+	const uint16_t x = position.x;
+	const uint16_t y = position.y;
+	const uint16_t mirrorX = static_cast<uint16_t>(_columns - 1 - x);
+	const uint16_t mirrorY = static_cast<uint16_t>(_rows - 1 - y);
+
+	// The last four are only valid for square boards, where mirrorX & mirrorY can stand in for each other.
+	switch (symmetry)
+	{
+		case BoardSymmetry::Identity:		return { x, y };
+		case BoardSymmetry::FlipHorizontal:	return { mirrorX, y };
+		case BoardSymmetry::FlipVertical:	return { x, mirrorY };
+		case BoardSymmetry::Rotate180:		return { mirrorX, mirrorY };
+		case BoardSymmetry::Transpose:		return { y, x };
+		case BoardSymmetry::Rotate90:		return { mirrorY, x };
+		case BoardSymmetry::Rotate270:		return { y, mirrorX };
+		case BoardSymmetry::AntiTranspose:	return { mirrorY, mirrorX };
+		default:							return position;
+	}
+}
+
+BoardSymmetry GameBoard::GetInverseSymmetry(BoardSymmetry symmetry)
+{
+	// Every symmetry other than the quarter turns is its own inverse.
+	switch (symmetry)
+	{
+		case BoardSymmetry::Rotate90:	return BoardSymmetry::Rotate270;
+		case BoardSymmetry::Rotate270:	return BoardSymmetry::Rotate90;
+		default:						return symmetry;
+	}
+}
+
+uint32_t GameBoard::GetRandomFreeCell(uint64_t random) const
+{
+	assert(GetFreeCellCount() > 0);
+	return _freeCells[sGetRandomIndex(random, GetFreeCellCount())];
+}
+
+uint32_t GameBoard::GetRandomFrontierCell(uint64_t random) const
+{
+	assert(_frontierCellCount > 0);
+	return _frontierCells[sGetRandomIndex(random, _frontierCellCount)];
+}
+
+void GameBoard::MoveToFreeCellSlot(uint32_t cellIndex, uint32_t slot)
+{
+	const uint32_t previousSlot = _freeCellSlots[cellIndex];
+	const uint32_t displacedCellIndex = _freeCells[slot];
+
+	_freeCells[previousSlot] = displacedCellIndex;
+	_freeCellSlots[displacedCellIndex] = previousSlot;
+	_freeCells[slot] = cellIndex;
+	_freeCellSlots[cellIndex] = slot;
+}
+
+void GameBoard::UpdateSymmetryHashes(PlayerID playerID, const BoardPosition& position)
+{
+	for (uint16_t i = 0; i < GetSymmetryCount(); i++)
+	{
+		const BoardPosition transformed = TransformPosition(position, static_cast<BoardSymmetry>(i));
+		_symmetryHashes[i] ^= _zobristTable->GetKey(GetCellIndex(transformed), playerID);
+	}
+}
+
+void GameBoard::UpdateFrontier(const BoardPosition& position, bool isMarked)
+{
+	if (_frontierDistance == 0)
+	{
+		return;
+	}
+
+	const uint32_t cellIndex = GetCellIndex(position);
+	if (isMarked && IsFrontierCell(cellIndex))
+	{
+		RemoveFrontierCell(cellIndex);
+	}
+
+	// Only the cells whose count moves between zero and non-zero can enter or leave the frontier.
+	const int32_t distance = _frontierDistance;
+	const int32_t minX = std::max<int32_t>(position.x - distance, 0);
+	const int32_t maxX = std::min<int32_t>(position.x + distance, _columns - 1);
+	const int32_t minY = std::max<int32_t>(position.y - distance, 0);
+	const int32_t maxY = std::min<int32_t>(position.y + distance, _rows - 1);
+	for (int32_t y = minY; y <= maxY; y++)
+	{
+		for (int32_t x = minX; x <= maxX; x++)
+		{
+			const BoardPosition neighbor = { static_cast<uint16_t>(x), static_cast<uint16_t>(y) };
+			const uint32_t neighborIndex = GetCellIndex(neighbor);
+			FrontierCount& frontierCount = _frontierCounts[neighborIndex];
+			if (frontierCount.generation != _generation)
+			{
+				frontierCount = { _generation, 0 };
+			}
+
+			if (isMarked)
+			{
+				if (++frontierCount.count == 1 && GetMarker(neighbor) == kInvalidPlayerID)
+				{
+					AddFrontierCell(neighborIndex);
+				}
+			}
+			else
+			{
+				assert(frontierCount.count > 0);
+				if (--frontierCount.count == 0 && IsFrontierCell(neighborIndex))
+				{
+					RemoveFrontierCell(neighborIndex);
+				}
+			}
+		}
+	}
+
+	if (!isMarked && _frontierCounts[cellIndex].count > 0)
+	{
+		AddFrontierCell(cellIndex);
+	}
+}
+
+bool GameBoard::IsFrontierCell(uint32_t cellIndex) const
+{
+	const uint32_t slot = _frontierSlots[cellIndex];
+	return (slot < _frontierCellCount) && (_frontierCells[slot] == cellIndex);
+}
+
+void GameBoard::AddFrontierCell(uint32_t cellIndex)
+{
+	_frontierCells[_frontierCellCount] = cellIndex;
+	_frontierSlots[cellIndex] = _frontierCellCount;
+	_frontierCellCount++;
+}
+
+void GameBoard::RemoveFrontierCell(uint32_t cellIndex)
+{
+	const uint32_t slot = _frontierSlots[cellIndex];
+	const uint32_t lastCellIndex = _frontierCells[--_frontierCellCount];
+	_frontierCells[slot] = lastCellIndex;
+	_frontierSlots[lastCellIndex] = slot;
+}
+
+MarkResult GameBoard::ValidateMark(PlayerID playerID, const BoardPosition& position) const
+{
+	assert(playerID < GetNumPlayers());
+	(void)playerID;
+
+	MarkResult result;
+	if (_winningPlayerID != kInvalidPlayerID)
+	{
+		result = MarkResult::GameAlreadyOver;
+	}
+	else if (!IsValidPosition(position))
+	{
+		result = MarkResult::PositionOutOfBounds;
+	}
+	else if (GetMarker(position) != kInvalidPlayerID)
+	{
+		result = MarkResult::PositionAlreadyMarked;
+	}
+	else
+	{
+		result = MarkResult::Success;
+	}
+	return result;
+}
+
+// Updates all of the board state for a new marker, except for the win state.
+void GameBoard::PlaceMarker(PlayerID playerID, const BoardPosition& position)
+{
+	const uint32_t cellIndex = GetCellIndex(position);
+	GetCell(position) = { _generation, playerID };
+	_playerBoards[playerID].Set(position.x, position.y);
+	UpdateSymmetryHashes(playerID, position);
+	MoveToFreeCellSlot(cellIndex, GetFreeCellCount() - 1);
+	_markerCount++;
+	UpdateFrontier(position, true);
 }
 
 void GameBoard::CheckForWin(PlayerID playerID, const BoardPosition& position)
+{
+	const BitBoard& playerBoard = _playerBoards[playerID];
+	for (const Offset& offset : kWinOffsets)
+	{
+		// The BitBoard scans lines top-to-bottom; flip the offset if needed (it describes the same line).
+		const int16_t sign = (offset.y > 0) ? 1 : -1;
+		if (playerBoard.HasRunThrough(position.x, position.y, sign * offset.x, sign * offset.y, _winCondition))
+		{
+			RecordWin(playerID, position);
+			break;
+		}
+	}
+}
+
+// Records the given player as the winner, along with every winning line through the given (just marked) position.
+void GameBoard::RecordWin(PlayerID playerID, const BoardPosition& position)
 {
 	assert(_winningPlayerID == kInvalidPlayerID);
 	assert(_winningPositions.empty());
 
-	struct Offset {
-		int16_t x;
-		int16_t y;
-	};
-
-	const Offset offsets[4] =
-	{
-		{ -1,  1 },	// '/' - forward slash
-		{ -1,  0 }, // '-' - horizontal
-		{ -1, -1 },	// '\' - backslash
-		{  0, -1 },	// '|' - vertical
-	};
 	const uint16_t remainingSteps = (_winCondition - 1);
+	const BitBoard& playerBoard = _playerBoards[playerID];
 
-	for (int i = 0; i < 4; i++)
+	for (const Offset& offset : kWinOffsets)
 	{
-		const Offset& offset = offsets[i];
-		uint16_t a = CountConsecutive(playerID, position, offset.x, offset.y, remainingSteps);
-		uint16_t b = CountConsecutive(playerID, position, -offset.x, -offset.y, remainingSteps);
-		if (a + b >= remainingSteps)
+		uint16_t a = CountConsecutive(playerBoard, position, offset.x, offset.y, remainingSteps);
+		uint16_t b = CountConsecutive(playerBoard, position, -offset.x, -offset.y, remainingSteps);
+		if (a + b + 1 >= _winCondition)
 		{
 			for (int16_t i = -a; i <= b; i++)
 			{
@@ -158,10 +473,8 @@ void GameBoard::CheckForWin(PlayerID playerID, const BoardPosition& position)
 		}
 	}
 
-	if (!_winningPositions.empty())
-	{
-		_winningPlayerID = playerID;
-	}
+	assert(!_winningPositions.empty());
+	_winningPlayerID = playerID;
 }
 
 void GameBoard::ClearWin()
@@ -171,24 +484,22 @@ void GameBoard::ClearWin()
 }
 
 uint16_t GameBoard::CountConsecutive(
-	PlayerID marker,
+	const BitBoard& playerBoard,
 	BoardPosition position,
 	int16_t xOffset, int16_t yOffset,
 	uint16_t remainingSteps) const
 {
-	position.x += xOffset;
-	position.y += yOffset;
-	remainingSteps--;
-
 	uint16_t result = 0;
-	if (IsValidPosition(position) &&
-		GetMarker(position) == marker)
+	for (; remainingSteps > 0; remainingSteps--)
 	{
-		result += 1;
-		if (remainingSteps > 0)
+		position.x += xOffset;
+		position.y += yOffset;
+		if (!IsValidPosition(position) ||
+			!playerBoard.Test(position.x, position.y))
 		{
-			result += CountConsecutive(marker, position, xOffset, yOffset, remainingSteps);
+			break;
 		}
+		result++;
 	}
 	return result;
 }
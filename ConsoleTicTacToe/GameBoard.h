@@ -1,5 +1,9 @@
 #pragma once
 
+#include "BitBoard.h"
+#include "ZobristTable.h"
+
+#include <memory>
 #include <vector>
 
 namespace tictactoe
@@ -7,6 +11,8 @@ namespace tictactoe
 	typedef uint16_t PlayerID;
 	static const PlayerID kInvalidPlayerID = -1;
 
+	static const uint16_t kDefaultFrontierDistance = 2;
+
 	enum class MarkResult
 	{
 		Success = 0,
@@ -32,12 +38,31 @@ namespace tictactoe
 		uint16_t y;
 	};
 
+	// The ways a board can be reflected or rotated onto itself. Every board has the first four;
+	// only square boards have the last four.
+	enum class BoardSymmetry : uint8_t
+	{
+		Identity = 0,
+		FlipHorizontal,		// Mirrors the columns.
+		FlipVertical,		// Mirrors the rows.
+		Rotate180,
+		Transpose,			// Mirrors along the main diagonal.
+		Rotate90,			// Clockwise.
+		Rotate270,			// Clockwise.
+		AntiTranspose,		// Mirrors along the anti-diagonal.
+
+		Count
+	};
+
 	struct PlayerMove
 	{
 		PlayerID playerID;
 		BoardPosition position;
 	};
 
+	inline bool operator==(const BoardPosition& a, const BoardPosition& b) { return a.x == b.x && a.y == b.y; }
+	inline bool operator==(const PlayerMove& a, const PlayerMove& b) { return a.playerID == b.playerID && a.position == b.position; }
+
 	// Represents the 2-dimensional game board that a m,n,k-game is played on, where:
 	// - m is the number of columns of the game board
 	// - n is the number of rows of the game board
@@ -48,12 +73,21 @@ namespace tictactoe
 	public:
 		typedef std::vector<BoardPosition> WinPositionList;
 
-		GameBoard(uint16_t columns, uint16_t rows, uint16_t winCondition);
+		// frontierDistance is how far (in any direction) from a marker an empty cell may be to be in the frontier;
+		// 0 disables the frontier entirely.
+		GameBoard(
+			uint16_t columns, uint16_t rows, uint16_t winCondition, uint16_t numPlayers,
+			uint16_t frontierDistance = kDefaultFrontierDistance);
+		GameBoard(const GameBoard& other);
+		GameBoard& operator=(const GameBoard& other);
 		virtual ~GameBoard();
 
-		MarkResult Mark(PlayerID playerID, const BoardPosition& position);
-		UnmarkResult Unmark(PlayerID playerID, const BoardPosition& position);
-		void Clear();
+		// Returns a copy of the board with the same dynamic type.
+		virtual std::unique_ptr<GameBoard> Clone() const;
+
+		virtual MarkResult Mark(PlayerID playerID, const BoardPosition& position);
+		virtual UnmarkResult Unmark(PlayerID playerID, const BoardPosition& position);
+		virtual void Clear();
 
 		bool IsValidPosition(const BoardPosition& position) const;
 		PlayerID GetMarker(const BoardPosition& position) const;
@@ -61,16 +95,76 @@ namespace tictactoe
 		uint16_t GetRows() const { return _rows; }
 		uint16_t GetColumns() const { return _columns; }
 		uint16_t GetWinCondition() const { return _winCondition; }
+		uint16_t GetNumPlayers() const { return static_cast<uint16_t>(_playerBoards.size()); }
 
-		bool IsFilled() const { return _markerCount >= _columns * _rows; }
+		uint32_t GetMarkerCount() const { return _markerCount; }
+		bool IsFilled() const { return _markerCount >= GetCellCount(); }
 		PlayerID GetWinningPlayer() const { return _winningPlayerID; }
 		const WinPositionList& GetWinPositionList() const { return _winningPositions; }
 
+		// A Zobrist hash of the current markers, updated incrementally by Mark(), Unmark() and Clear().
+		uint64_t GetHash() const { return _symmetryHashes[0]; }
+
+		// The hash of the board as it would be after applying each symmetry; these are also kept up to date
+		// incrementally. The canonical symmetry is the one with the smallest hash, so every orientation of a
+		// position has the same canonical hash.
+		uint16_t GetSymmetryCount() const { return (_columns == _rows) ? kMaxSymmetryCount : (kMaxSymmetryCount / 2); }
+		uint64_t GetSymmetryHash(BoardSymmetry symmetry) const { return _symmetryHashes[static_cast<size_t>(symmetry)]; }
+		BoardSymmetry GetCanonicalSymmetry() const;
+		uint64_t GetCanonicalHash() const { return GetSymmetryHash(GetCanonicalSymmetry()); }
+
+		// Maps a position on this board to where the symmetry moves it; GetInverseSymmetry() maps it back.
+		BoardPosition TransformPosition(const BoardPosition& position, BoardSymmetry symmetry) const;
+		static BoardSymmetry GetInverseSymmetry(BoardSymmetry symmetry);
+		uint32_t GetCellIndex(const BoardPosition& position) const { return (position.y * static_cast<uint32_t>(_columns)) + position.x; }
+		BoardPosition GetCellPosition(uint32_t cellIndex) const { return { static_cast<uint16_t>(cellIndex % _columns), static_cast<uint16_t>(cellIndex / _columns) }; }
+		uint32_t GetCellCount() const { return static_cast<uint32_t>(_columns) * _rows; }
+
+		// The indices of the empty cells, in no particular order (which changes as cells are marked & unmarked).
+		uint32_t GetFreeCellCount() const { return GetCellCount() - _markerCount; }
+		uint32_t GetFreeCell(uint32_t freeCellIndex) const { return _freeCells[freeCellIndex]; }
+		uint32_t GetRandomFreeCell(uint64_t random) const;
+
+		// The 'frontier': the empty cells within GetFrontierDistance() columns & rows of any marker, in no
+		// particular order. On large boards these are the only moves worth considering.
+		uint16_t GetFrontierDistance() const { return _frontierDistance; }
+		uint32_t GetFrontierCellCount() const { return _frontierCellCount; }
+		uint32_t GetFrontierCell(uint32_t frontierCellIndex) const { return _frontierCells[frontierCellIndex]; }
+		uint32_t GetRandomFrontierCell(uint64_t random) const;
+
+	protected:
+		// The pieces of Mark() that subclasses with their own win detection can reuse.
+		MarkResult ValidateMark(PlayerID playerID, const BoardPosition& position) const;
+		void PlaceMarker(PlayerID playerID, const BoardPosition& position);
+		void RecordWin(PlayerID playerID, const BoardPosition& position);
+
 	private:
+		// A grid cell is only considered marked if its generation matches the board's current generation,
+		// which allows Clear() to reset the whole grid by simply advancing the generation.
+		struct Cell
+		{
+			uint16_t generation;
+			PlayerID playerID;
+		};
+
+		Cell& GetCell(const BoardPosition& position) { return _cells[position.y * _rowStride + position.x]; }
+		const Cell& GetCell(const BoardPosition& position) const { return _cells[position.y * _rowStride + position.x]; }
+
+		void AllocateCells();
+		void FreeCells();
+
+		void MoveToFreeCellSlot(uint32_t cellIndex, uint32_t slot);
+		void UpdateSymmetryHashes(PlayerID playerID, const BoardPosition& position);
+
+		void UpdateFrontier(const BoardPosition& position, bool isMarked);
+		bool IsFrontierCell(uint32_t cellIndex) const;
+		void AddFrontierCell(uint32_t cellIndex);
+		void RemoveFrontierCell(uint32_t cellIndex);
+
 		void CheckForWin(PlayerID playerID, const BoardPosition& position);
 		void ClearWin();
 		uint16_t CountConsecutive(
-			PlayerID marker,
+			const BitBoard& playerBoard,
 			BoardPosition position,
 			int16_t xOffset, int16_t yOffset,
 			uint16_t remainingSteps) const;
@@ -79,8 +173,42 @@ namespace tictactoe
 		uint16_t _rows;			// n
 		uint16_t _winCondition;	// k
 
-		PlayerID** _grid;
-		uint16_t _markerCount;
+		// A single cache-line aligned allocation, with each row padded to a whole number of cache lines.
+		void* _cellAllocation;
+		Cell* _cells;
+		uint32_t _rowStride;
+		uint16_t _generation;
+		uint32_t _markerCount;
+
+		// A permutation of every cell index where the first GetFreeCellCount() entries are the empty cells,
+		// along with each cell's slot in it. Marking a cell swaps it to the end of the empty section and unmarking
+		// swaps it back, so Clear() only needs to reset the marker count.
+		std::vector<uint32_t> _freeCells;
+		std::vector<uint32_t> _freeCellSlots;
+
+		// The number of markers within the frontier distance of each cell, stamped with the board generation
+		// it was counted in (like the cells themselves) so Clear() doesn't need to reset them.
+		struct FrontierCount
+		{
+			uint16_t generation;
+			uint16_t count;
+		};
+
+		// The frontier is a sparse set: a cell is in it if its slot is below the count and points back at it,
+		// so stale slots never need to be cleared either.
+		uint16_t _frontierDistance;
+		std::vector<FrontierCount> _frontierCounts;
+		std::vector<uint32_t> _frontierCells;
+		std::vector<uint32_t> _frontierSlots;
+		uint32_t _frontierCellCount;
+
+		// One BitBoard per player, used for win detection.
+		std::vector<BitBoard> _playerBoards;
+
+		// Shared between copies of the board; the keys only depend on the board dimensions & player count.
+		std::shared_ptr<const ZobristTable> _zobristTable;
+		static const uint16_t kMaxSymmetryCount = static_cast<uint16_t>(BoardSymmetry::Count);
+		uint64_t _symmetryHashes[kMaxSymmetryCount];
 
 		PlayerID _winningPlayerID;
 		WinPositionList _winningPositions;
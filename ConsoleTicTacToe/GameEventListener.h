@@ -0,0 +1,30 @@
+#pragma once
+
+#include "GameBoard.h"
+
+#include <vector>
+
+namespace tictactoe
+{
+	// Is told about every change a GameSimulation makes to its game state (see GameSimulation::AddEventListener()),
+	// e.g. to record the game as it's played.
+	class GameEventListener
+	{
+	public:
+		virtual ~GameEventListener() {}
+
+		// The board has been cleared for a new game.
+		virtual void OnGameStarted(const GameBoard& gameBoard) = 0;
+
+		// A move has been played or redone.
+		virtual void OnMoveApplied(const PlayerMove& move) = 0;
+
+		// A move has been undone.
+		virtual void OnMoveReverted(const PlayerMove& move) = 0;
+
+		// The game has jumped straight to another position of the current line (see GameSimulation::SeekTo()), which
+		// the board already shows: the given moves have either all been undone (most recent first) or all been redone
+		// (in the order they're played). Listeners that only show the position can simply resync from the board.
+		virtual void OnSeek(const GameBoard& gameBoard, const std::vector<PlayerMove>& moves, bool isUndo) = 0;
+	};
+}
@@ -0,0 +1,287 @@
+#include "GameRecord.h"
+
+#include "FixedGameBoard.h"
+#include "GameSimulation.h"
+
+#include <cassert>
+#include <cstring>
+#include <fstream>
+#include <ostream>
+
+using namespace tictactoe;
+
+// The initial capacity of a writer's token buffer; it grows past this for longer games.
+static const size_t kWriteBufferSize = 4096;
+
+bool GameRecordWriter::OpenFile(const char* path, std::ofstream* outStream)
+{
+	outStream->open(path, std::ios::binary | std::ios::app);
+	if (!outStream->is_open())
+	{
+		return false;
+	}
+
+	// In append mode every write goes to the end, so the end is where the file size can be read from.
+	outStream->seekp(0, std::ios::end);
+	if (outStream->tellp() == std::streampos(0))
+	{
+		outStream->write(reinterpret_cast<const char*>(GameRecordFormat::kMagic), sizeof(GameRecordFormat::kMagic));
+		outStream->put(static_cast<char>(GameRecordFormat::kVersion));
+	}
+	return outStream->good();
+}
+
+GameRecordWriter::GameRecordWriter(std::ostream& stream, std::mutex* streamMutex) :
+	_stream(stream),
+	_streamMutex(streamMutex),
+	_buffer(),
+	_isRecordOpen(false),
+	_isRecordEmpty(true),
+	_columns(0)
+{
+	_buffer.reserve(kWriteBufferSize);
+}
+
+GameRecordWriter::~GameRecordWriter()
+{
+	EndRecord();
+}
+
+void GameRecordWriter::OnGameStarted(const GameBoard& gameBoard)
+{
+	EndRecord();
+
+	_isRecordOpen = true;
+	_isRecordEmpty = true;
+	_columns = gameBoard.GetColumns();
+	WriteVarint(gameBoard.GetColumns());
+	WriteVarint(gameBoard.GetRows());
+	WriteVarint(gameBoard.GetWinCondition());
+	WriteVarint(gameBoard.GetNumPlayers());
+}
+
+void GameRecordWriter::OnMoveApplied(const PlayerMove& move)
+{
+	assert(_isRecordOpen);
+	const uint64_t cellIndex = (static_cast<uint64_t>(move.position.y) * _columns) + move.position.x;
+	WriteVarint(GameRecordFormat::kFirstMoveToken + cellIndex);
+	_isRecordEmpty = false;
+}
+
+void GameRecordWriter::OnMoveReverted(const PlayerMove& move)
+{
+	(void)move;
+	assert(_isRecordOpen);
+	WriteVarint(GameRecordFormat::kUndoToken);
+	_isRecordEmpty = false;
+}
+
+void GameRecordWriter::OnSeek(const GameBoard& gameBoard, const std::vector<PlayerMove>& moves, bool isUndo)
+{
+	(void)gameBoard;
+	for (const PlayerMove& move : moves)
+	{
+		if (isUndo)
+		{
+			OnMoveReverted(move);
+		}
+		else
+		{
+			OnMoveApplied(move);
+		}
+	}
+}
+
+void GameRecordWriter::EndRecord()
+{
+	if (_isRecordOpen)
+	{
+		if (_isRecordEmpty)
+		{
+			_buffer.clear();
+		}
+		else
+		{
+			WriteVarint(GameRecordFormat::kEndToken);
+			WriteBuffer();
+		}
+		_isRecordOpen = false;
+	}
+}
+
+void GameRecordWriter::WriteVarint(uint64_t value)
+{
+	while (value >= 0x80)
+	{
+		_buffer.push_back(static_cast<uint8_t>(value | 0x80));
+		value >>= 7;
+	}
+	_buffer.push_back(static_cast<uint8_t>(value));
+}
+
+void GameRecordWriter::WriteBuffer()
+{
+	if (_streamMutex != nullptr)
+	{
+		std::lock_guard<std::mutex> lock(*_streamMutex);
+		_stream.write(reinterpret_cast<const char*>(_buffer.data()), _buffer.size());
+	}
+	else
+	{
+		_stream.write(reinterpret_cast<const char*>(_buffer.data()), _buffer.size());
+		_stream.flush();
+	}
+	_buffer.clear();
+}
+
+GameRecordReader::GameRecordReader(const uint8_t* data, size_t size) :
+	_data(data),
+	_cursor(data),
+	_end(data + size),
+	_isValid(false)
+{
+	if (size >= GameRecordFormat::kFileHeaderSize &&
+		memcmp(data, GameRecordFormat::kMagic, sizeof(GameRecordFormat::kMagic)) == 0 &&
+		data[sizeof(GameRecordFormat::kMagic)] == GameRecordFormat::kVersion)
+	{
+		_cursor += GameRecordFormat::kFileHeaderSize;
+		_isValid = true;
+	}
+}
+
+bool GameRecordReader::ReadNext(GameRecord* outRecord)
+{
+	if (!_isValid || _cursor == _end)
+	{
+		return false;
+	}
+
+	const uint8_t* cursor = _cursor;
+	uint64_t header[4];
+	for (uint64_t& value : header)
+	{
+		if (!ReadVarint(&cursor, _end, &value) || value == 0 || value > UINT16_MAX)
+		{
+			_isValid = false;
+			return false;
+		}
+	}
+
+	// Find the end token; a record cut short (e.g. by a crash while writing) ends the data.
+	const uint8_t* tokens = cursor;
+	const uint8_t* tokensEnd;
+	uint64_t token;
+	do
+	{
+		tokensEnd = cursor;
+		if (!ReadVarint(&cursor, _end, &token))
+		{
+			_isValid = false;
+			return false;
+		}
+	} while (token != GameRecordFormat::kEndToken);
+
+	outRecord->columns = static_cast<uint16_t>(header[0]);
+	outRecord->rows = static_cast<uint16_t>(header[1]);
+	outRecord->winCondition = static_cast<uint16_t>(header[2]);
+	outRecord->numPlayers = static_cast<uint16_t>(header[3]);
+	outRecord->tokens = tokens;
+	outRecord->tokensSize = static_cast<size_t>(tokensEnd - tokens);
+
+	_cursor = cursor;
+	return true;
+}
+
+void GameRecordReader::Seek(size_t offset)
+{
+	assert(offset >= GameRecordFormat::kFileHeaderSize && offset <= static_cast<size_t>(_end - _data));
+	_cursor = _data + offset;
+}
+
+bool GameRecordReader::ReadVarint(const uint8_t** cursor, const uint8_t* end, uint64_t* outValue)
+{
+	uint64_t value = 0;
+	for (uint32_t shift = 0; shift < 64 && *cursor != end; shift += 7)
+	{
+		const uint8_t byte = *(*cursor)++;
+		value |= static_cast<uint64_t>(byte & 0x7F) << shift;
+		if ((byte & 0x80) == 0)
+		{
+			*outValue = value;
+			return true;
+		}
+	}
+	return false;
+}
+
+void GameRecordReader::ReadFinalLine(const GameRecord& record, std::vector<uint32_t>* outMoves)
+{
+	outMoves->clear();
+
+	const uint8_t* cursor = record.tokens;
+	const uint8_t* end = record.tokens + record.tokensSize;
+	uint64_t token;
+	while (ReadVarint(&cursor, end, &token))
+	{
+		if (token == GameRecordFormat::kUndoToken)
+		{
+			if (!outMoves->empty())
+			{
+				outMoves->pop_back();
+			}
+		}
+		else if (token >= GameRecordFormat::kFirstMoveToken)
+		{
+			outMoves->push_back(static_cast<uint32_t>(token - GameRecordFormat::kFirstMoveToken));
+		}
+	}
+}
+
+void tictactoe::WriteGameRecordText(std::ostream& stream, const GameRecord& record, uint64_t gameNumber)
+{
+	std::vector<uint32_t> moves;
+	GameRecordReader::ReadFinalLine(record, &moves);
+
+	// Replay the moves to find the result.
+	std::unique_ptr<GameBoard> gameBoard = CreateGameBoard(record.columns, record.rows, record.winCondition, record.numPlayers);
+	PlayerID playerID = 0;
+	for (uint32_t move : moves)
+	{
+		if (move >= gameBoard->GetCellCount() || gameBoard->Mark(playerID, gameBoard->GetCellPosition(move)) != MarkResult::Success)
+		{
+			break;
+		}
+		playerID = (playerID + 1) % record.numPlayers;
+	}
+
+	const char* result = "*";
+	if (gameBoard->GetWinningPlayer() != kInvalidPlayerID)
+	{
+		result = (gameBoard->GetWinningPlayer() == 0) ? "1-0" : "0-1";
+	}
+	else if (gameBoard->IsFilled())
+	{
+		result = "1/2-1/2";
+	}
+
+	stream << "[Game \"" << gameNumber << "\"]" << std::endl;
+	stream << "[Board \"" << record.columns << "x" << record.rows << "\"]" << std::endl;
+	stream << "[WinCondition \"" << record.winCondition << "\"]" << std::endl;
+	for (PlayerID i = 0; i < record.numPlayers && i < GameSimulation::kNumPlayers; i++)
+	{
+		stream << "[" << GameSimulation::GetPlayerChar(i) << " \"" << GameSimulation::GetPlayerName(i) << "\"]" << std::endl;
+	}
+	stream << "[Result \"" << result << "\"]" << std::endl;
+	stream << std::endl;
+
+	for (size_t i = 0; i < moves.size(); i++)
+	{
+		if (i % record.numPlayers == 0)
+		{
+			stream << ((i / record.numPlayers) + 1) << ". ";
+		}
+		stream << (moves[i] % record.columns) << "," << (moves[i] / record.columns) << " ";
+	}
+	stream << result << std::endl;
+	stream << std::endl;
+}
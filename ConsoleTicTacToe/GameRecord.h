@@ -0,0 +1,111 @@
+#pragma once
+
+#include "GameEventListener.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <iosfwd>
+#include <mutex>
+#include <vector>
+
+namespace tictactoe
+{
+	// The binary game record format.
+	//
+	// A file starts with the 4 byte magic "MNKG" and a version byte, followed by any number of records. A record is
+	// its header (m, n, k & the number of players) and then its tokens, all as LEB128 varints:
+	// - kEndToken ends the record.
+	// - kUndoToken takes back the last move.
+	// - Any other token T marks cell T - kFirstMoveToken (see GameBoard::GetCellIndex()) for the next player.
+	// Moves near the top-left corner of a board therefore take a single byte, and none take more than 5.
+	namespace GameRecordFormat
+	{
+		static const uint8_t kMagic[4] = { 'M', 'N', 'K', 'G' };
+		static const uint8_t kVersion = 1;
+		static const size_t kFileHeaderSize = sizeof(kMagic) + sizeof(kVersion);
+
+		static const uint64_t kEndToken = 0;
+		static const uint64_t kUndoToken = 1;
+		static const uint64_t kFirstMoveToken = 2;
+	}
+
+	// A single record of a game, pointing into the data it was read from.
+	struct GameRecord
+	{
+		uint16_t columns;
+		uint16_t rows;
+		uint16_t winCondition;
+		uint16_t numPlayers;
+		const uint8_t* tokens;
+		size_t tokensSize;	// Not including the end token.
+	};
+
+	// Appends a record of each game played by the GameSimulation it listens to to a stream. The whole record of the
+	// current game is buffered, and only written out (end token included) when the next game starts or the writer
+	// is destroyed, so a crash mid-game never leaves an unterminated record for the next writer to append to.
+	// Several writers can share one stream by also sharing a mutex. Games without any moves aren't recorded.
+	class GameRecordWriter : public GameEventListener
+	{
+	public:
+		// Opens the given file to append records to, writing the file header first if the file is new or empty.
+		static bool OpenFile(const char* path, std::ofstream* outStream);
+
+		explicit GameRecordWriter(std::ostream& stream, std::mutex* streamMutex = nullptr);
+		virtual ~GameRecordWriter();
+
+		virtual void OnGameStarted(const GameBoard& gameBoard) override;
+		virtual void OnMoveApplied(const PlayerMove& move) override;
+		virtual void OnMoveReverted(const PlayerMove& move) override;
+		virtual void OnSeek(const GameBoard& gameBoard, const std::vector<PlayerMove>& moves, bool isUndo) override;
+
+		// Ends the current record (if any) and writes it to the stream.
+		void EndRecord();
+
+	private:
+		void WriteVarint(uint64_t value);
+		void WriteBuffer();
+
+		std::ostream& _stream;
+		std::mutex* _streamMutex;
+
+		std::vector<uint8_t> _buffer;
+		bool _isRecordOpen;
+		bool _isRecordEmpty;
+		uint16_t _columns;
+	};
+
+	// Reads records one at a time out of a block of record file data (typically a MappedFile) without allocating.
+	class GameRecordReader
+	{
+	public:
+		GameRecordReader(const uint8_t* data, size_t size);
+
+		// False if the data doesn't start with a valid file header.
+		bool IsValid() const { return _isValid; }
+
+		// Reads the next record, returning false at the end of the data or if the next record is malformed.
+		bool ReadNext(GameRecord* outRecord);
+
+		// The offset of the next record in the data, which Seek() can later return to (e.g. to split a file's
+		// records between threads without keeping them all).
+		size_t GetOffset() const { return static_cast<size_t>(_cursor - _data); }
+		void Seek(size_t offset);
+
+		// Reads a varint from [*cursor, end), advancing the cursor past it.
+		static bool ReadVarint(const uint8_t** cursor, const uint8_t* end, uint64_t* outValue);
+
+		// The moves of the record's final line (what's left after applying its undos) as cell indices.
+		// outMoves is reused, so reading many records this way doesn't allocate once it has grown.
+		static void ReadFinalLine(const GameRecord& record, std::vector<uint32_t>* outMoves);
+
+	private:
+		const uint8_t* _data;
+		const uint8_t* _cursor;
+		const uint8_t* _end;
+		bool _isValid;
+	};
+
+	// Writes a record as text in the style of a chess PGN file: a few [Tag "value"] pairs, then the numbered moves
+	// of its final line as x,y coordinates, then the result.
+	void WriteGameRecordText(std::ostream& stream, const GameRecord& record, uint64_t gameNumber);
+}
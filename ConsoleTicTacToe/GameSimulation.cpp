@@ -1,9 +1,22 @@
 #include "GameSimulation.h"
 
+#include "FixedGameBoard.h"
+
+#include <algorithm>
+#include <type_traits>
+
 using namespace tictactoe;
 
+static const uint64_t kMaxReservedMoveCount = 1 << 20;
+
+// Saving & restoring a checkpoint copies the whole board, so on larger boards they're spaced further apart;
+// either way a full game has at most about kCheckpointsPerGame of them on any one line.
+static const uint64_t kMinCheckpointInterval = 64;
+static const uint64_t kCheckpointsPerGame = 64;
+
 static PlayerID sGetNextPlayerID(PlayerID id);
 static PlayerID sGetPrevPlayerID(PlayerID id);
+static bool sHasHumanPlayer(const GameSimulation& game);
 
 const char* GameSimulation::GetPlayerName(PlayerID playerID)
 {
@@ -28,11 +41,19 @@ char GameSimulation::GetPlayerChar(PlayerID playerID)
 }
 
 GameSimulation::GameSimulation(uint16_t m, uint16_t n, uint16_t k) :
-	_gameBoard(m, n, k),
+	_gameBoard(CreateGameBoard(m, n, k, kNumPlayers)),
 	_moveHistory(),
+	_checkpoints(),
+	_checkpointInterval(std::max<uint64_t>(kMinCheckpointInterval, (static_cast<uint64_t>(m) * n) / kCheckpointsPerGame)),
+	_seekPath(),
+	_seekMoves(),
 	_activePlayer(0),
-	_gameStatus(GameStatus::Active)
+	_gameStatus(GameStatus::Active),
+	_aiPlayers(),
+	_eventListeners()
 {
+	// A game can't last longer than m * n moves; very large boards rarely fill up, so they just grow the history as needed.
+	_moveHistory.Reserve(std::min<uint64_t>(static_cast<uint64_t>(m) * n, kMaxReservedMoveCount));
 	_moveHistory.SetCallbacks(
 		[=](const PlayerMove& move) { this->ApplyUndo(move); },
 		[=](const PlayerMove& move) { this->ApplyRedo(move); });
@@ -45,24 +66,52 @@ GameSimulation::~GameSimulation()
 
 void GameSimulation::Reset()
 {
-	_gameBoard.Clear();
+	_gameBoard->Clear();
 	_moveHistory.Clear();
+	for (Checkpoint& checkpoint : _checkpoints)
+	{
+		checkpoint.node = MoveHistory::kNoNode;
+	}
 	_activePlayer = 0;
 	UpdateGameStatus();
+
+	for (GameEventListener* eventListener : _eventListeners)
+	{
+		eventListener->OnGameStarted(*_gameBoard);
+	}
 }
 
 MarkResult GameSimulation::Mark(const BoardPosition& position)
 {
-	auto result = _gameBoard.Mark(_activePlayer, position);
+	auto result = _gameBoard->Mark(_activePlayer, position);
 	if (result == MarkResult::Success)
 	{
 		_moveHistory.Add({ _activePlayer, position });
+		SaveCheckpoint();
+		for (GameEventListener* eventListener : _eventListeners)
+		{
+			eventListener->OnMoveApplied({ _activePlayer, position });
+		}
 		_activePlayer = sGetNextPlayerID(_activePlayer);
 		UpdateGameStatus();
 	}
 	return result;
 }
 
+MarkResult GameSimulation::MarkAIMove(BoardPosition* outPosition)
+{
+	assert(_gameStatus == GameStatus::Active);
+	assert(IsAIPlayer(_activePlayer));
+
+	// The AI player searches on the actual game board, restoring it before returning its move.
+	const BoardPosition position = _aiPlayers[_activePlayer]->ChooseMove(*_gameBoard, _activePlayer);
+	if (outPosition != nullptr)
+	{
+		*outPosition = position;
+	}
+	return Mark(position);
+}
+
 bool GameSimulation::Undo()
 {
 	return _moveHistory.Undo();
@@ -74,13 +123,187 @@ bool GameSimulation::Redo()
 	return _moveHistory.Redo();
 }
 
+bool GameSimulation::UndoTurn()
+{
+	bool result = Undo();
+	if (result && sHasHumanPlayer(*this))
+	{
+		while (IsAIPlayer(_activePlayer) && Undo())
+		{
+			// Keep undoing.
+		}
+	}
+	return result;
+}
+
+bool GameSimulation::RedoTurn()
+{
+	bool result = Redo();
+	if (result && sHasHumanPlayer(*this))
+	{
+		while (_gameStatus == GameStatus::Active && IsAIPlayer(_activePlayer) && Redo())
+		{
+			// Keep redoing.
+		}
+	}
+	return result;
+}
+
+bool GameSimulation::JumpTo(MoveHistory::NodeIndex nodeIndex)
+{
+	return _moveHistory.JumpTo(nodeIndex);
+}
+
+bool GameSimulation::SeekTo(uint64_t moveIndex)
+{
+	typedef MoveHistory::NodeIndex NodeIndex;
+
+	const uint64_t currentMoveIndex = _moveHistory.GetAvailableUndosCount();
+	if (moveIndex > currentMoveIndex + _moveHistory.GetAvailableRedosCount())
+	{
+		return false;
+	}
+
+	const NodeIndex currentNode = _moveHistory.GetCurrentNode();
+	NodeIndex targetNode = currentNode;
+	for (uint64_t i = currentMoveIndex; i > moveIndex; i--)
+	{
+		targetNode = _moveHistory.GetParent(targetNode);
+	}
+	for (uint64_t i = currentMoveIndex; i < moveIndex; i++)
+	{
+		targetNode = _moveHistory.GetRedoChild(targetNode);
+	}
+
+	// Collect the moves between the target and the closest checkpoint before it (or the empty board).
+	_seekPath.clear();
+	NodeIndex checkpointNode = targetNode;
+	const Checkpoint* checkpoint = nullptr;
+	while (checkpointNode != MoveHistory::kRootNode)
+	{
+		const uint64_t depth = _moveHistory.GetDepth(checkpointNode);
+		if (depth % _checkpointInterval == 0)
+		{
+			const size_t slot = static_cast<size_t>(depth / _checkpointInterval) - 1;
+			if (slot < _checkpoints.size() && _checkpoints[slot].node == checkpointNode)
+			{
+				checkpoint = &_checkpoints[slot];
+				break;
+			}
+		}
+		_seekPath.push_back(checkpointNode);
+		checkpointNode = _moveHistory.GetParent(checkpointNode);
+	}
+
+	const uint64_t seekDistance = (moveIndex > currentMoveIndex) ? (moveIndex - currentMoveIndex) : (currentMoveIndex - moveIndex);
+	VisitGameBoard(*_gameBoard, [&](auto& board)
+	{
+		typedef typename std::decay<decltype(board)>::type Board;
+		const BoardApplyPolicy<Board> applyPolicy(&board);
+
+		if (seekDistance <= _seekPath.size())
+		{
+			// The target is closer to the current move than to any checkpoint, so walk there directly.
+			NodeIndex node = currentNode;
+			while (node != targetNode)
+			{
+				if (moveIndex < currentMoveIndex)
+				{
+					applyPolicy.ApplyUndo(_moveHistory.GetMove(node));
+					node = _moveHistory.GetParent(node);
+				}
+				else
+				{
+					node = _moveHistory.GetRedoChild(node);
+					applyPolicy.ApplyRedo(_moveHistory.GetMove(node));
+				}
+			}
+			return;
+		}
+
+		if (checkpoint != nullptr)
+		{
+			board = static_cast<const Board&>(*checkpoint->gameBoard);
+		}
+		else
+		{
+			board.Clear();
+		}
+		for (auto it = _seekPath.rbegin(); it != _seekPath.rend(); ++it)
+		{
+			applyPolicy.ApplyRedo(_moveHistory.GetMove(*it));
+		}
+	});
+
+	_moveHistory.MoveTo(targetNode);
+	_activePlayer = static_cast<PlayerID>(moveIndex % kNumPlayers);
+	UpdateGameStatus();
+
+	// The listeners hear about the whole seek at once, with the moves in between for those that need them.
+	if (!_eventListeners.empty())
+	{
+		const bool isUndo = (moveIndex < currentMoveIndex);
+		const NodeIndex deeperNode = isUndo ? currentNode : targetNode;
+		const NodeIndex shallowerNode = isUndo ? targetNode : currentNode;
+		_seekMoves.clear();
+		for (NodeIndex node = deeperNode; node != shallowerNode; node = _moveHistory.GetParent(node))
+		{
+			_seekMoves.push_back(_moveHistory.GetMove(node));
+		}
+		if (!isUndo)
+		{
+			std::reverse(_seekMoves.begin(), _seekMoves.end());
+		}
+
+		for (GameEventListener* eventListener : _eventListeners)
+		{
+			eventListener->OnSeek(*_gameBoard, _seekMoves, isUndo);
+		}
+	}
+	return true;
+}
+
+void GameSimulation::AddEventListener(GameEventListener* eventListener)
+{
+	assert(std::find(_eventListeners.begin(), _eventListeners.end(), eventListener) == _eventListeners.end());
+	_eventListeners.push_back(eventListener);
+
+	_seekPath.clear();
+	for (MoveHistory::NodeIndex node = _moveHistory.GetCurrentNode(); node != MoveHistory::kRootNode; node = _moveHistory.GetParent(node))
+	{
+		_seekPath.push_back(node);
+	}
+
+	eventListener->OnGameStarted(*_gameBoard);
+	for (auto it = _seekPath.rbegin(); it != _seekPath.rend(); ++it)
+	{
+		eventListener->OnMoveApplied(_moveHistory.GetMove(*it));
+	}
+}
+
+void GameSimulation::RemoveEventListener(GameEventListener* eventListener)
+{
+	_eventListeners.erase(std::remove(_eventListeners.begin(), _eventListeners.end(), eventListener), _eventListeners.end());
+}
+
+void GameSimulation::SetAIPlayer(PlayerID playerID, std::unique_ptr<AIPlayer> aiPlayer)
+{
+	assert(playerID < kNumPlayers);
+	_aiPlayers[playerID] = std::move(aiPlayer);
+}
+
+bool GameSimulation::IsAIPlayer(PlayerID playerID) const
+{
+	return (playerID < kNumPlayers && _aiPlayers[playerID] != nullptr);
+}
+
 void GameSimulation::UpdateGameStatus()
 {
-	if (_gameBoard.GetWinningPlayer() != kInvalidPlayerID)
+	if (_gameBoard->GetWinningPlayer() != kInvalidPlayerID)
 	{
 		_gameStatus = GameStatus::Won;
 	}
-	else if (_gameBoard.IsFilled())
+	else if (_gameBoard->IsFilled())
 	{
 		_gameStatus = GameStatus::Draw;
 	}
@@ -92,19 +315,65 @@ void GameSimulation::UpdateGameStatus()
 
 void GameSimulation::ApplyUndo(const PlayerMove& move)
 {
-	auto result = _gameBoard.Unmark(move.playerID, move.position);
+	auto result = _gameBoard->Unmark(move.playerID, move.position);
 	assert(result == UnmarkResult::Success);
 	_activePlayer = sGetPrevPlayerID(_activePlayer);
 	UpdateGameStatus();
+
+	for (GameEventListener* eventListener : _eventListeners)
+	{
+		eventListener->OnMoveReverted(move);
+	}
 }
 
 
 void GameSimulation::ApplyRedo(const PlayerMove& move)
 {
-	auto result = _gameBoard.Mark(move.playerID, move.position);
+	auto result = _gameBoard->Mark(move.playerID, move.position);
 	assert(result == MarkResult::Success);
 	_activePlayer = sGetNextPlayerID(_activePlayer);
 	UpdateGameStatus();
+
+	for (GameEventListener* eventListener : _eventListeners)
+	{
+		eventListener->OnMoveApplied(move);
+	}
+}
+
+void GameSimulation::SaveCheckpoint()
+{
+	const MoveHistory::NodeIndex node = _moveHistory.GetCurrentNode();
+	const uint64_t depth = _moveHistory.GetDepth(node);
+	if (depth == 0 || depth % _checkpointInterval != 0)
+	{
+		return;
+	}
+
+	const size_t slot = static_cast<size_t>(depth / _checkpointInterval) - 1;
+	while (_checkpoints.size() <= slot)
+	{
+		_checkpoints.push_back({ MoveHistory::kNoNode, nullptr });
+	}
+
+	Checkpoint& checkpoint = _checkpoints[slot];
+	if (checkpoint.node == node)
+	{
+		return;
+	}
+
+	if (checkpoint.gameBoard == nullptr)
+	{
+		checkpoint.gameBoard = _gameBoard->Clone();
+	}
+	else
+	{
+		VisitGameBoard(*_gameBoard, [&](auto& board)
+		{
+			typedef typename std::decay<decltype(board)>::type Board;
+			static_cast<Board&>(*checkpoint.gameBoard) = board;
+		});
+	}
+	checkpoint.node = node;
 }
 
 static PlayerID sGetNextPlayerID(PlayerID id)
@@ -116,3 +385,15 @@ static PlayerID sGetPrevPlayerID(PlayerID id)
 {
 	return (id + GameSimulation::kNumPlayers - 1) % GameSimulation::kNumPlayers;
 }
+
+static bool sHasHumanPlayer(const GameSimulation& game)
+{
+	for (PlayerID playerID = 0; playerID < GameSimulation::kNumPlayers; playerID++)
+	{
+		if (!game.IsAIPlayer(playerID))
+		{
+			return true;
+		}
+	}
+	return false;
+}
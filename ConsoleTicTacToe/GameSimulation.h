@@ -1,7 +1,13 @@
 #pragma once
 
+#include "AIPlayer.h"
 #include "GameBoard.h"
-#include "UndoManager.h"
+#include "GameEventListener.h"
+#include "UndoTree.h"
+
+#include <cassert>
+#include <memory>
+#include <vector>
 
 namespace tictactoe
 {
@@ -14,13 +20,41 @@ namespace tictactoe
 		Count
 	};
 
+	// An UndoTree ApplyPolicy that un- & re- marks moves directly on a game board, without any of GameSimulation's
+	// per-move bookkeeping, for replaying many moves at once (see SeekTo()). Templated on the board type so that the
+	// calls on a FixedGameBoard are non-virtual.
+	template <typename Board>
+	class BoardApplyPolicy
+	{
+	public:
+		explicit BoardApplyPolicy(Board* gameBoard = nullptr) : _gameBoard(gameBoard) {}
+
+		void ApplyUndo(const PlayerMove& move) const
+		{
+			auto result = _gameBoard->Unmark(move.playerID, move.position);
+			assert(result == UnmarkResult::Success);
+			(void)result;
+		}
+
+		void ApplyRedo(const PlayerMove& move) const
+		{
+			auto result = _gameBoard->Mark(move.playerID, move.position);
+			assert(result == MarkResult::Success);
+			(void)result;
+		}
+
+	private:
+		Board* _gameBoard;
+	};
+
 	// An abstract base class for a 2-player m,n,k-game simulation.
 	// Maintains the game board, active player, and undo history state,
 	// and provides an interface for manipulating that state (see Mark(), Undo(), and Redo()).
 	class GameSimulation
 	{
 	public:
-		typedef UndoManager<PlayerMove> MoveHistory;
+		// Keeps every line that has been played, not just the current one; see JumpTo().
+		typedef UndoTree<PlayerMove> MoveHistory;
 
 		static const uint16_t kNumPlayers = 2;
 
@@ -34,27 +68,68 @@ namespace tictactoe
 		virtual bool Update() = 0;
 		virtual void Reset();
 
-		const GameBoard& GetGameBoard() const { return _gameBoard; }
+		const GameBoard& GetGameBoard() const { return *_gameBoard; }
 		const MoveHistory& GetMoveHistory() const { return _moveHistory; }
 
 		GameStatus GetGameStatus() const { return _gameStatus; }
 		PlayerID GetActivePlayer() const { return _gameStatus == GameStatus::Active ? _activePlayer : kInvalidPlayerID; }
-		PlayerID GetWinningPlayer() const { return _gameStatus == GameStatus::Won ? _gameBoard.GetWinningPlayer() : kInvalidPlayerID; }
+		PlayerID GetWinningPlayer() const { return _gameStatus == GameStatus::Won ? _gameBoard->GetWinningPlayer() : kInvalidPlayerID; }
+
+		// A new listener is told about the current game straight away, as though its moves had just been played.
+		// Listeners aren't owned by the simulation.
+		void AddEventListener(GameEventListener* eventListener);
+		void RemoveEventListener(GameEventListener* eventListener);
+
+		void SetAIPlayer(PlayerID playerID, std::unique_ptr<AIPlayer> aiPlayer);
+		bool IsAIPlayer(PlayerID playerID) const;
 
 		MarkResult Mark(const BoardPosition& position);
+		MarkResult MarkAIMove(BoardPosition* outPosition);
 		bool Undo();
 		bool Redo();
 
+		// Like Undo() & Redo(), but also steps over any AI players' moves so that a human player is active afterwards.
+		bool UndoTurn();
+		bool RedoTurn();
+
+		// Moves to any node in the move history, un- & re- applying only the moves in between.
+		bool JumpTo(MoveHistory::NodeIndex nodeIndex);
+
+		// Moves to the given move of the current line (0 being the empty board) by restoring the closest checkpoint
+		// and replaying the rest directly on the board. Unlike Undo() & Redo(), ApplyUndo() & ApplyRedo() aren't
+		// called for each move in between, and listeners get a single OnSeek() once the board is there.
+		bool SeekTo(uint64_t moveIndex);
+
 	protected:
 		void UpdateGameStatus();
 		virtual void ApplyUndo(const PlayerMove& move);
 		virtual void ApplyRedo(const PlayerMove& move);
 
 	private:
-		GameBoard _gameBoard;
+		// A copy of the board at a history node whose depth is a multiple of the checkpoint interval.
+		struct Checkpoint
+		{
+			MoveHistory::NodeIndex node;	// MoveHistory::kNoNode while unused.
+			std::unique_ptr<GameBoard> gameBoard;
+		};
+
+		void SaveCheckpoint();
+
+		// A FixedGameBoard when the size has one; see CreateGameBoard().
+		std::unique_ptr<GameBoard> _gameBoard;
 		MoveHistory _moveHistory;
 
+		// One checkpoint per interval of depth, holding the board at that depth of whichever line was last played
+		// through it; the boards are copied over rather than reallocated when the line changes.
+		std::vector<Checkpoint> _checkpoints;
+		uint64_t _checkpointInterval;
+		std::vector<MoveHistory::NodeIndex> _seekPath;
+		std::vector<PlayerMove> _seekMoves;
+
 		PlayerID _activePlayer;
 		GameStatus _gameStatus;
+
+		std::unique_ptr<AIPlayer> _aiPlayers[kNumPlayers];
+		std::vector<GameEventListener*> _eventListeners;
 	};
 }
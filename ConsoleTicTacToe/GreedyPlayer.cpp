@@ -0,0 +1,57 @@
+#include "GreedyPlayer.h"
+
+using namespace tictactoe;
+
+static bool sIsWinningMove(GameBoard& gameBoard, PlayerID playerID, const BoardPosition& position);
+
+GreedyPlayer::GreedyPlayer(uint64_t seed) :
+	// xorshift gets stuck on a zero state.
+	_randomState(seed != 0 ? seed : 0x9E3779B97F4A7C15ull),
+	_candidateMoves()
+{
+}
+
+GreedyPlayer::~GreedyPlayer()
+{
+}
+
+BoardPosition GreedyPlayer::SearchMove(GameBoard& gameBoard, PlayerID playerID)
+{
+	const bool isFrontierSearch = IsFrontierSearch(gameBoard);
+	const PlayerID nextPlayerID = (playerID + 1) % gameBoard.GetNumPlayers();
+
+	// Marking & unmarking reorders the board's candidate moves, so they're copied out first.
+	_candidateMoves.clear();
+	const uint32_t candidateMoveCount = GetCandidateMoveCount(gameBoard, isFrontierSearch);
+	for (uint32_t i = 0; i < candidateMoveCount; i++)
+	{
+		_candidateMoves.push_back(GetCandidateMove(gameBoard, isFrontierSearch, i));
+	}
+
+	uint32_t blockingMove = UINT32_MAX;
+	for (uint32_t move : _candidateMoves)
+	{
+		const BoardPosition position = gameBoard.GetCellPosition(move);
+		if (sIsWinningMove(gameBoard, playerID, position))
+		{
+			return position;
+		}
+		if (blockingMove == UINT32_MAX && sIsWinningMove(gameBoard, nextPlayerID, position))
+		{
+			blockingMove = move;
+		}
+	}
+
+	const uint32_t move = (blockingMove != UINT32_MAX) ?
+		blockingMove :
+		GetRandomCandidateMove(gameBoard, isFrontierSearch, NextRandom(_randomState));
+	return gameBoard.GetCellPosition(move);
+}
+
+static bool sIsWinningMove(GameBoard& gameBoard, PlayerID playerID, const BoardPosition& position)
+{
+	gameBoard.Mark(playerID, position);
+	const bool result = (gameBoard.GetWinningPlayer() == playerID);
+	gameBoard.Unmark(playerID, position);
+	return result;
+}
@@ -0,0 +1,24 @@
+#pragma once
+
+#include "AIPlayer.h"
+
+#include <vector>
+
+namespace tictactoe
+{
+	// A computer player that only looks one move ahead: it completes a line if it can, otherwise blocks the next
+	// player from completing one, and otherwise plays a random candidate move.
+	class GreedyPlayer : public AIPlayer
+	{
+	public:
+		explicit GreedyPlayer(uint64_t seed);
+		virtual ~GreedyPlayer();
+
+	protected:
+		virtual BoardPosition SearchMove(GameBoard& gameBoard, PlayerID playerID) override;
+
+	private:
+		uint64_t _randomState;
+		std::vector<uint32_t> _candidateMoves;
+	};
+}
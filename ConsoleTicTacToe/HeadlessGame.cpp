@@ -0,0 +1,37 @@
+#include "HeadlessGame.h"
+
+#include <cassert>
+
+using namespace tictactoe;
+
+HeadlessGame::HeadlessGame(uint16_t m, uint16_t n, uint16_t k) :
+	GameSimulation(m, n, k)
+{
+}
+
+HeadlessGame::~HeadlessGame()
+{
+}
+
+bool HeadlessGame::Update()
+{
+	if (GetGameStatus() != GameStatus::Active)
+	{
+		return false;
+	}
+
+	auto result = MarkAIMove(nullptr);
+	assert(result == MarkResult::Success);
+	(void)result;
+
+	return (GetGameStatus() == GameStatus::Active);
+}
+
+GameStatus HeadlessGame::PlayToEnd()
+{
+	while (Update())
+	{
+		// Keep playing.
+	}
+	return GetGameStatus();
+}
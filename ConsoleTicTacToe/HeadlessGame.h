@@ -0,0 +1,21 @@
+#pragma once
+
+#include "GameSimulation.h"
+
+namespace tictactoe
+{
+	// A GameSimulation without any input or output, for games played entirely between AI players (see RunSelfPlay()).
+	// Each Update() plays a single move.
+	class HeadlessGame : public GameSimulation
+	{
+	public:
+		HeadlessGame(uint16_t m, uint16_t n, uint16_t k);
+		virtual ~HeadlessGame();
+
+		// Returns false once the game is over.
+		virtual bool Update() override;
+
+		// Plays moves until the game is over.
+		GameStatus PlayToEnd();
+	};
+}
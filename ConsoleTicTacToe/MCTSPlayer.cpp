@@ -0,0 +1,345 @@
+#include "MCTSPlayer.h"
+
+#include "FixedGameBoard.h"
+
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <thread>
+
+using namespace tictactoe;
+
+enum : uint8_t
+{
+	kNodeUnexpanded = 0,
+	kNodeExpanding,
+	kNodeExpanded,
+	kNodeLeaf,		// Permanently left unexpanded because the node pool ran out.
+};
+
+static const uint32_t kExpansionVisitThreshold = 4;
+static const uint32_t kPlayoutsPerTimeCheck = 64;
+static const double kExplorationConstant = 1.41421356;
+
+static PlayerID sGetMover(PlayerID rootPlayerID, size_t pathIndex);
+static uint32_t sGetScore(PlayerID winningPlayerID, PlayerID playerID);
+
+MCTSPlayer::MCTSPlayer(uint32_t playoutLimit, uint32_t moveTimeMs, uint32_t nodePoolSizeMB, uint16_t threadCount) :
+	_playoutLimit(playoutLimit),
+	_moveTimeMs(moveTimeMs),
+	_nodePool(),
+	_nodePoolCapacity(0),
+	_nodePoolSize(0),
+	_workers(),
+	_playoutCount(0),
+	_isStopRequested(false),
+	_deadline(),
+	_lastSearchStats()
+{
+	assert(playoutLimit > 0 || moveTimeMs > 0);
+	assert(threadCount > 0);
+
+	const uint64_t nodeCount = (static_cast<uint64_t>(std::max<uint32_t>(nodePoolSizeMB, 1)) << 20) / sizeof(Node);
+	_nodePoolCapacity = static_cast<uint32_t>(std::min<uint64_t>(nodeCount, UINT32_MAX - 1));
+	_nodePool.reset(new Node[_nodePoolCapacity]);
+
+	const uint64_t seed = static_cast<uint64_t>(Clock::now().time_since_epoch().count());
+	_workers.resize(threadCount);
+	for (uint16_t i = 0; i < threadCount; i++)
+	{
+		_workers[i].index = i;
+		_workers[i].randomState = seed + ((i + 1) * 0x9E3779B97F4A7C15ull);
+	}
+}
+
+MCTSPlayer::~MCTSPlayer()
+{
+}
+
+BoardPosition MCTSPlayer::SearchMove(GameBoard& gameBoard, PlayerID playerID)
+{
+	assert(gameBoard.GetNumPlayers() == 2);
+	assert(gameBoard.GetWinningPlayer() == kInvalidPlayerID);
+	assert(!gameBoard.IsFilled());
+
+	const Clock::time_point startTime = Clock::now();
+	_deadline = startTime + std::chrono::milliseconds(_moveTimeMs);
+	_isStopRequested = false;
+	_playoutCount = 0;
+
+	// The tree is rebuilt for every move, so the whole pool is available again.
+	_nodePoolSize = 0;
+	const uint32_t rootIndex = AllocateNodes(1);
+	InitializeNode(rootIndex, UINT32_MAX);
+	const bool isRootExpanded = TryExpand(rootIndex, gameBoard);
+	assert(isRootExpanded);
+	(void)isRootExpanded;
+
+	for (Worker& worker : _workers)
+	{
+		worker.playoutCount = 0;
+	}
+
+	// With only one legal move there's nothing to search.
+	const Node& root = _nodePool[rootIndex];
+	if (root.childCount > 1)
+	{
+		// The first worker plays on the given board directly; every other worker plays on its own copy.
+		for (Worker& worker : _workers)
+		{
+			worker.gameBoardCopy = (worker.index > 0) ? gameBoard.Clone() : nullptr;
+		}
+
+		// Dispatching on the board type once here lets the playouts use a FixedGameBoard's non-virtual calls.
+		VisitGameBoard(gameBoard, [this, playerID](auto& board) { SearchInParallel(board, playerID); });
+	}
+
+	// The most visited move is the most robust choice; its value estimate has had the most playouts behind it.
+	uint32_t bestChild = root.firstChild;
+	for (uint32_t i = 0; i < root.childCount; i++)
+	{
+		const uint32_t child = root.firstChild + i;
+		if (_nodePool[child].visitCount > _nodePool[bestChild].visitCount)
+		{
+			bestChild = child;
+		}
+	}
+
+	SearchStats stats = {};
+	for (const Worker& worker : _workers)
+	{
+		stats.playoutCount += worker.playoutCount;
+	}
+	stats.nodeCount = std::min(_nodePoolSize.load(), _nodePoolCapacity);
+	stats.threadCount = static_cast<uint16_t>(_workers.size());
+	const auto elapsed = Clock::now() - startTime;
+	stats.elapsedMs = static_cast<uint32_t>(std::chrono::duration_cast<std::chrono::milliseconds>(elapsed).count());
+	const double elapsedSeconds = std::chrono::duration<double>(elapsed).count();
+	stats.playoutsPerSecond = (elapsedSeconds > 0.0) ? (stats.playoutCount / elapsedSeconds) : 0.0;
+	_lastSearchStats = stats;
+
+	return gameBoard.GetCellPosition(_nodePool[bestChild].move);
+}
+
+template<typename Board>
+void MCTSPlayer::SearchInParallel(Board& gameBoard, PlayerID rootPlayerID)
+{
+	std::vector<std::thread> helperThreads;
+	for (size_t i = 1; i < _workers.size(); i++)
+	{
+		helperThreads.emplace_back([this, i, rootPlayerID]()
+		{
+			RunWorker(_workers[i], static_cast<Board&>(*_workers[i].gameBoardCopy), rootPlayerID);
+		});
+	}
+	RunWorker(_workers[0], gameBoard, rootPlayerID);
+	_isStopRequested = true;
+	for (std::thread& helperThread : helperThreads)
+	{
+		helperThread.join();
+	}
+}
+
+template<typename Board>
+void MCTSPlayer::RunWorker(Worker& worker, Board& gameBoard, PlayerID rootPlayerID)
+{
+	while (!IsStopRequested(worker))
+	{
+		RunIteration(worker, gameBoard, rootPlayerID);
+		worker.playoutCount++;
+	}
+}
+
+template<typename Board>
+void MCTSPlayer::RunIteration(Worker& worker, Board& gameBoard, PlayerID rootPlayerID)
+{
+	PlayerID playerID = rootPlayerID;
+
+	// Selection: walk down the tree, applying a virtual loss (a visit without any score) to each node on the way.
+	uint32_t nodeIndex = 0;
+	_nodePool[nodeIndex].visitCount.fetch_add(1, std::memory_order_relaxed);
+	worker.path.clear();
+	worker.path.push_back(nodeIndex);
+
+	bool isGameOver = false;
+	for (;;)
+	{
+		const Node& node = _nodePool[nodeIndex];
+		if (node.expansionState.load(std::memory_order_acquire) != kNodeExpanded &&
+			(node.visitCount.load(std::memory_order_relaxed) < kExpansionVisitThreshold || !TryExpand(nodeIndex, gameBoard)))
+		{
+			break;
+		}
+
+		nodeIndex = SelectChild(node);
+		Node& child = _nodePool[nodeIndex];
+		child.visitCount.fetch_add(1, std::memory_order_relaxed);
+		worker.path.push_back(nodeIndex);
+
+		const MarkResult result = gameBoard.Mark(playerID, gameBoard.GetCellPosition(child.move));
+		assert(result == MarkResult::Success);
+		(void)result;
+		playerID = static_cast<PlayerID>(1 - playerID);
+
+		if (gameBoard.GetWinningPlayer() != kInvalidPlayerID || gameBoard.IsFilled())
+		{
+			isGameOver = true;
+			break;
+		}
+	}
+
+	// Simulation.
+	const PlayerID winningPlayerID = isGameOver ? gameBoard.GetWinningPlayer() : Playout(worker, gameBoard, playerID);
+
+	// Backpropagation; the visits were already counted during selection, which also removes the virtual loss.
+	for (size_t i = worker.path.size(); i-- > 0;)
+	{
+		const PlayerID mover = sGetMover(rootPlayerID, i);
+		Node& node = _nodePool[worker.path[i]];
+		node.score.fetch_add(sGetScore(winningPlayerID, mover), std::memory_order_relaxed);
+		if (i > 0)
+		{
+			gameBoard.Unmark(mover, gameBoard.GetCellPosition(node.move));
+		}
+	}
+}
+
+uint32_t MCTSPlayer::SelectChild(const Node& node) const
+{
+	const double logParentVisits = std::log(static_cast<double>(std::max<uint32_t>(node.visitCount.load(std::memory_order_relaxed), 1)));
+
+	uint32_t bestChild = node.firstChild;
+	double bestValue = -1.0;
+	for (uint32_t i = 0; i < node.childCount; i++)
+	{
+		const uint32_t childIndex = node.firstChild + i;
+		const Node& child = _nodePool[childIndex];
+		const uint32_t visitCount = child.visitCount.load(std::memory_order_relaxed);
+		if (visitCount == 0)
+		{
+			return childIndex;
+		}
+
+		const double exploitation = child.score.load(std::memory_order_relaxed) / (2.0 * visitCount);
+		const double exploration = kExplorationConstant * std::sqrt(logParentVisits / visitCount);
+		const double value = exploitation + exploration;
+		if (value > bestValue)
+		{
+			bestValue = value;
+			bestChild = childIndex;
+		}
+	}
+	return bestChild;
+}
+
+template<typename Board>
+bool MCTSPlayer::TryExpand(uint32_t nodeIndex, const Board& gameBoard)
+{
+	Node& node = _nodePool[nodeIndex];
+	uint8_t expected = kNodeUnexpanded;
+	if (!node.expansionState.compare_exchange_strong(expected, kNodeExpanding, std::memory_order_acquire))
+	{
+		// Another worker is expanding (or has expanded) this node; until it's done the node is treated as a leaf.
+		return (expected == kNodeExpanded);
+	}
+
+	const bool isFrontierSearch = IsFrontierSearch(gameBoard);
+	const uint32_t childCount = GetCandidateMoveCount(gameBoard, isFrontierSearch);
+	const uint32_t firstChild = AllocateNodes(childCount);
+	if (firstChild == kNoNode)
+	{
+		node.expansionState.store(kNodeLeaf, std::memory_order_relaxed);
+		return false;
+	}
+
+	for (uint32_t i = 0; i < childCount; i++)
+	{
+		InitializeNode(firstChild + i, GetCandidateMove(gameBoard, isFrontierSearch, i));
+	}
+
+	node.firstChild = firstChild;
+	node.childCount = childCount;
+	node.expansionState.store(kNodeExpanded, std::memory_order_release);
+	return true;
+}
+
+template<typename Board>
+PlayerID MCTSPlayer::Playout(Worker& worker, Board& gameBoard, PlayerID playerID)
+{
+	// Play uniformly random moves until the game ends, then take them all back again.
+	// On large boards the moves are kept to the frontier, like the tree's, so that a playout stays local
+	// rather than scattering markers over the whole board.
+	const bool isFrontierSearch = IsFrontierSearch(gameBoard) && gameBoard.GetMarkerCount() > 0;
+	const PlayerID firstPlayerID = playerID;
+	worker.playoutMoves.clear();
+	while (!gameBoard.IsFilled() && gameBoard.GetWinningPlayer() == kInvalidPlayerID)
+	{
+		const uint64_t random = NextRandom(worker.randomState);
+		const uint32_t cell = isFrontierSearch ? gameBoard.GetRandomFrontierCell(random) : gameBoard.GetRandomFreeCell(random);
+		gameBoard.Mark(playerID, gameBoard.GetCellPosition(cell));
+		worker.playoutMoves.push_back(cell);
+		playerID = static_cast<PlayerID>(1 - playerID);
+	}
+
+	const PlayerID winningPlayerID = gameBoard.GetWinningPlayer();
+	for (size_t i = worker.playoutMoves.size(); i-- > 0;)
+	{
+		gameBoard.Unmark(static_cast<PlayerID>((firstPlayerID + i) % 2), gameBoard.GetCellPosition(worker.playoutMoves[i]));
+	}
+	return winningPlayerID;
+}
+
+uint32_t MCTSPlayer::AllocateNodes(uint32_t count)
+{
+	// Checking before reserving keeps a pool that has run out from growing its size without bound.
+	if (count > _nodePoolCapacity || _nodePoolSize.load(std::memory_order_relaxed) > _nodePoolCapacity - count)
+	{
+		return kNoNode;
+	}
+
+	const uint32_t first = _nodePoolSize.fetch_add(count, std::memory_order_relaxed);
+	return (first <= _nodePoolCapacity - count) ? first : kNoNode;
+}
+
+void MCTSPlayer::InitializeNode(uint32_t nodeIndex, uint32_t move)
+{
+	Node& node = _nodePool[nodeIndex];
+	node.move = move;
+	node.firstChild = kNoNode;
+	node.childCount = 0;
+	node.visitCount.store(0, std::memory_order_relaxed);
+	node.score.store(0, std::memory_order_relaxed);
+	node.expansionState.store(kNodeUnexpanded, std::memory_order_relaxed);
+}
+
+bool MCTSPlayer::IsStopRequested(Worker& worker)
+{
+	if (_isStopRequested.load(std::memory_order_relaxed))
+	{
+		return true;
+	}
+
+	// Each worker reserves its playouts from the shared count, so exactly _playoutLimit are played in total.
+	if ((_playoutLimit > 0 && _playoutCount.fetch_add(1, std::memory_order_relaxed) >= _playoutLimit) ||
+		(_moveTimeMs > 0 && (worker.playoutCount % kPlayoutsPerTimeCheck) == 0 && Clock::now() >= _deadline))
+	{
+		_isStopRequested = true;
+		return true;
+	}
+	return false;
+}
+
+// The root node's move was made by the opponent of the player to move; from there the movers alternate.
+static PlayerID sGetMover(PlayerID rootPlayerID, size_t pathIndex)
+{
+	return static_cast<PlayerID>((rootPlayerID + pathIndex + 1) % 2);
+}
+
+static uint32_t sGetScore(PlayerID winningPlayerID, PlayerID playerID)
+{
+	if (winningPlayerID == kInvalidPlayerID)
+	{
+		return 1;
+	}
+	return (winningPlayerID == playerID) ? 2 : 0;
+}
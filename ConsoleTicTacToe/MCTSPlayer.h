@@ -0,0 +1,93 @@
+#pragma once
+
+#include "AIPlayer.h"
+
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <vector>
+
+namespace tictactoe
+{
+	// A computer player that uses Monte Carlo tree search with UCT selection.
+	// See https://en.wikipedia.org/wiki/Monte_Carlo_tree_search
+	//
+	// The tree is shared by all worker threads ('tree parallelization'); a virtual loss is applied to every node a
+	// worker walks through so that concurrent workers spread out over different lines. Nodes are allocated from a
+	// fixed pool rather than individually, and each worker plays its random playouts on a private copy of the board.
+	class MCTSPlayer : public AIPlayer
+	{
+	public:
+		struct SearchStats
+		{
+			uint64_t playoutCount;
+			uint32_t nodeCount;
+			uint16_t threadCount;
+			uint32_t elapsedMs;
+			double playoutsPerSecond;
+		};
+
+		// The search stops after playoutLimit playouts or moveTimeMs milliseconds, whichever comes first;
+		// a value of 0 disables that limit (but at least one limit must be given).
+		MCTSPlayer(uint32_t playoutLimit, uint32_t moveTimeMs, uint32_t nodePoolSizeMB, uint16_t threadCount);
+		virtual ~MCTSPlayer();
+
+		const SearchStats& GetLastSearchStats() const { return _lastSearchStats; }
+
+	protected:
+		virtual BoardPosition SearchMove(GameBoard& gameBoard, PlayerID playerID) override;
+
+	private:
+		typedef std::chrono::steady_clock Clock;
+
+		static const uint32_t kNoNode = UINT32_MAX;
+
+		struct Node
+		{
+			uint32_t move;
+			uint32_t firstChild;
+			uint32_t childCount;
+
+			// Scores are in half-points (win = 2, draw = 1, loss = 0) for the player that made this node's move.
+			std::atomic<uint32_t> visitCount;
+			std::atomic<uint32_t> score;
+			std::atomic<uint8_t> expansionState;
+		};
+
+		// The state owned by each worker thread.
+		struct Worker
+		{
+			uint16_t index;
+			std::unique_ptr<GameBoard> gameBoardCopy;	// Unused by the first worker, which plays on the given board.
+			std::vector<uint32_t> path;
+			std::vector<uint32_t> playoutMoves;
+			uint64_t randomState;
+			uint64_t playoutCount;
+		};
+
+		// The search is templated on the board type (GameBoard or a FixedGameBoard); see VisitGameBoard().
+		template<typename Board> void SearchInParallel(Board& gameBoard, PlayerID rootPlayerID);
+		template<typename Board> void RunWorker(Worker& worker, Board& gameBoard, PlayerID rootPlayerID);
+		template<typename Board> void RunIteration(Worker& worker, Board& gameBoard, PlayerID rootPlayerID);
+		template<typename Board> bool TryExpand(uint32_t nodeIndex, const Board& gameBoard);
+		template<typename Board> PlayerID Playout(Worker& worker, Board& gameBoard, PlayerID playerID);
+		uint32_t SelectChild(const Node& node) const;
+		uint32_t AllocateNodes(uint32_t count);
+		void InitializeNode(uint32_t nodeIndex, uint32_t move);
+		bool IsStopRequested(Worker& worker);
+
+		uint32_t _playoutLimit;
+		uint32_t _moveTimeMs;
+
+		std::unique_ptr<Node[]> _nodePool;
+		uint32_t _nodePoolCapacity;
+		std::atomic<uint32_t> _nodePoolSize;
+
+		std::vector<Worker> _workers;
+		std::atomic<uint64_t> _playoutCount;
+		std::atomic<bool> _isStopRequested;
+		Clock::time_point _deadline;
+
+		SearchStats _lastSearchStats;
+	};
+}
@@ -0,0 +1,138 @@
+#include "MappedFile.h"
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+using namespace tictactoe;
+
+MappedFile::MappedFile() :
+	_data(nullptr),
+	_size(0),
+#ifdef _WIN32
+	_fileHandle(INVALID_HANDLE_VALUE),
+	_mappingHandle(nullptr)
+#else
+	_fileDescriptor(-1)
+#endif
+{
+}
+
+MappedFile::~MappedFile()
+{
+	Close();
+}
+
+#ifdef _WIN32
+
+bool MappedFile::Open(const char* path)
+{
+	Close();
+
+	_fileHandle = CreateFileA(path, GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+	LARGE_INTEGER fileSize;
+	if (_fileHandle == INVALID_HANDLE_VALUE || !GetFileSizeEx(_fileHandle, &fileSize))
+	{
+		Close();
+		return false;
+	}
+
+	// An empty file can't be mapped, but is still a valid (empty) file.
+	_size = static_cast<size_t>(fileSize.QuadPart);
+	if (_size == 0)
+	{
+		static const uint8_t kEmpty = 0;
+		_data = &kEmpty;
+		return true;
+	}
+
+	_mappingHandle = CreateFileMappingA(_fileHandle, nullptr, PAGE_READONLY, 0, 0, nullptr);
+	if (_mappingHandle != nullptr)
+	{
+		_data = static_cast<const uint8_t*>(MapViewOfFile(_mappingHandle, FILE_MAP_READ, 0, 0, 0));
+	}
+	if (_data == nullptr)
+	{
+		Close();
+		return false;
+	}
+	return true;
+}
+
+void MappedFile::Close()
+{
+	if (_data != nullptr && _mappingHandle != nullptr)
+	{
+		UnmapViewOfFile(_data);
+	}
+	if (_mappingHandle != nullptr)
+	{
+		CloseHandle(_mappingHandle);
+	}
+	if (_fileHandle != INVALID_HANDLE_VALUE)
+	{
+		CloseHandle(_fileHandle);
+	}
+
+	_data = nullptr;
+	_size = 0;
+	_fileHandle = INVALID_HANDLE_VALUE;
+	_mappingHandle = nullptr;
+}
+
+#else
+
+bool MappedFile::Open(const char* path)
+{
+	Close();
+
+	_fileDescriptor = open(path, O_RDONLY);
+	struct stat fileStat;
+	if (_fileDescriptor < 0 || fstat(_fileDescriptor, &fileStat) != 0)
+	{
+		Close();
+		return false;
+	}
+
+	// An empty file can't be mapped, but is still a valid (empty) file.
+	_size = static_cast<size_t>(fileStat.st_size);
+	if (_size == 0)
+	{
+		static const uint8_t kEmpty = 0;
+		_data = &kEmpty;
+		return true;
+	}
+
+	void* data = mmap(nullptr, _size, PROT_READ, MAP_PRIVATE, _fileDescriptor, 0);
+	if (data == MAP_FAILED)
+	{
+		Close();
+		return false;
+	}
+	madvise(data, _size, MADV_SEQUENTIAL);
+	_data = static_cast<const uint8_t*>(data);
+	return true;
+}
+
+void MappedFile::Close()
+{
+	if (_data != nullptr && _size > 0)
+	{
+		munmap(const_cast<uint8_t*>(_data), _size);
+	}
+	if (_fileDescriptor >= 0)
+	{
+		close(_fileDescriptor);
+	}
+
+	_data = nullptr;
+	_size = 0;
+	_fileDescriptor = -1;
+}
+
+#endif
@@ -0,0 +1,37 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+namespace tictactoe
+{
+	// A read-only view of a whole file, mapped into memory rather than read, so that large files can be scanned
+	// without loading them (the OS pages them in as they're touched).
+	class MappedFile
+	{
+	public:
+		MappedFile();
+		~MappedFile();
+
+		MappedFile(const MappedFile&) = delete;
+		MappedFile& operator=(const MappedFile&) = delete;
+
+		bool Open(const char* path);
+		void Close();
+
+		bool IsOpen() const { return _data != nullptr; }
+		const uint8_t* GetData() const { return _data; }
+		size_t GetSize() const { return _size; }
+
+	private:
+		const uint8_t* _data;
+		size_t _size;
+
+#ifdef _WIN32
+		void* _fileHandle;
+		void* _mappingHandle;
+#else
+		int _fileDescriptor;
+#endif
+	};
+}
@@ -0,0 +1,386 @@
+#include "MoveJournal.h"
+
+#include "GameSimulation.h"
+#include "MappedFile.h"
+
+#include <cassert>
+#include <cstring>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+using namespace tictactoe;
+using namespace tictactoe::MoveJournalFormat;
+
+static Header sMakeHeader(uint16_t m, uint16_t n, uint16_t k)
+{
+	Header header;
+	memcpy(header.magic, kMagic, sizeof(kMagic));
+	header.version = kVersion;
+	header.columns = m;
+	header.rows = n;
+	header.winCondition = k;
+	return header;
+}
+
+static bool sTryReadHeader(const MappedFile& file, Header* outHeader)
+{
+	if (file.GetSize() < sizeof(Header))
+	{
+		return false;
+	}
+
+	memcpy(outHeader, file.GetData(), sizeof(Header));
+	return memcmp(outHeader->magic, kMagic, sizeof(kMagic)) == 0 && outHeader->version == kVersion &&
+		outHeader->columns > 0 && outHeader->rows > 0 && outHeader->winCondition > 0;
+}
+
+bool MoveJournal::ReadBoardSize(const char* path, uint16_t* outM, uint16_t* outN, uint16_t* outK)
+{
+	MappedFile file;
+	Header header;
+	if (!file.Open(path) || !sTryReadHeader(file, &header))
+	{
+		return false;
+	}
+
+	*outM = header.columns;
+	*outN = header.rows;
+	*outK = header.winCondition;
+	return true;
+}
+
+bool MoveJournal::Replay(const char* path, GameSimulation* game)
+{
+	MappedFile file;
+	Header header;
+	if (!file.Open(path) || !sTryReadHeader(file, &header))
+	{
+		return false;
+	}
+
+	const GameBoard& gameBoard = game->GetGameBoard();
+	if (header.columns != gameBoard.GetColumns() || header.rows != gameBoard.GetRows() || header.winCondition != gameBoard.GetWinCondition())
+	{
+		return false;
+	}
+
+	// A partial record at the end is what's left of a write cut short, so it's ignored.
+	const Record* records = reinterpret_cast<const Record*>(file.GetData() + sizeof(Header));
+	const size_t recordCount = (file.GetSize() - sizeof(Header)) / sizeof(Record);
+
+	// Records are fixed-size, so the last reset can be found by scanning backwards from the end.
+	size_t firstRecord = recordCount;
+	while (firstRecord > 0 && records[firstRecord - 1].type != RecordType::Reset)
+	{
+		firstRecord--;
+	}
+
+	const GameSimulation::MoveHistory& moveHistory = game->GetMoveHistory();
+	for (size_t i = firstRecord; i < recordCount; i++)
+	{
+		const Record& record = records[i];
+		const PlayerMove move = { record.playerID, { record.x, record.y } };
+
+		switch (record.type)
+		{
+			case RecordType::Mark:
+				if (move.playerID != game->GetActivePlayer() || game->Mark(move.position) != MarkResult::Success)
+				{
+					return false;
+				}
+				break;
+
+			case RecordType::Undo:
+			{
+				// Runs of undos (e.g. from a jump back through the history) are replayed as a single seek.
+				GameSimulation::MoveHistory::NodeIndex node = moveHistory.GetCurrentNode();
+				uint64_t undoCount = 0;
+				for (; i < recordCount && records[i].type == RecordType::Undo; i++, undoCount++)
+				{
+					const PlayerMove undoMove = { records[i].playerID, { records[i].x, records[i].y } };
+					if (node == GameSimulation::MoveHistory::kRootNode || !(moveHistory.GetMove(node) == undoMove))
+					{
+						return false;
+					}
+					node = moveHistory.GetParent(node);
+				}
+				i--;
+
+				game->SeekTo(moveHistory.GetAvailableUndosCount() - undoCount);
+				break;
+			}
+
+			default:
+				return false;
+		}
+	}
+	return true;
+}
+
+MoveJournal::MoveJournal() :
+	_mutex(),
+	_condition(),
+	_pendingRecords(),
+	_isClosing(false),
+	_isMuted(false),
+	_syncRecords(),
+	_syncThread(),
+#ifdef _WIN32
+	_fileHandle(INVALID_HANDLE_VALUE)
+#else
+	_fileDescriptor(-1)
+#endif
+{
+}
+
+MoveJournal::~MoveJournal()
+{
+	Close();
+}
+
+bool MoveJournal::Open(const char* path, uint16_t m, uint16_t n, uint16_t k)
+{
+	Close();
+
+	uint64_t fileSize;
+	if (!OpenJournalFile(path, &fileSize))
+	{
+		return false;
+	}
+
+	const Header header = sMakeHeader(m, n, k);
+	bool result;
+	if (fileSize < sizeof(Header))
+	{
+		// A new journal, or one that was cut short before its header was complete.
+		result = TruncateJournalFile(0) && WriteJournalFile(&header, sizeof(header)) && SyncJournalFile();
+	}
+	else
+	{
+		// Drop any partial record at the end, so that new records are appended in line with the existing ones.
+		Header existingHeader;
+		const uint64_t recordsSize = ((fileSize - sizeof(Header)) / sizeof(Record)) * sizeof(Record);
+		result = ReadJournalFile(&existingHeader, sizeof(existingHeader)) &&
+			memcmp(&existingHeader, &header, sizeof(Header)) == 0 &&
+			TruncateJournalFile(sizeof(Header) + recordsSize);
+	}
+
+	if (!result)
+	{
+		CloseJournalFile();
+		return false;
+	}
+
+	_isClosing = false;
+	_syncThread = std::thread(&MoveJournal::SyncThreadMain, this);
+	return true;
+}
+
+void MoveJournal::Close()
+{
+	if (_syncThread.joinable())
+	{
+		{
+			std::lock_guard<std::mutex> lock(_mutex);
+			_isClosing = true;
+		}
+		_condition.notify_one();
+		_syncThread.join();
+	}
+	CloseJournalFile();
+}
+
+void MoveJournal::Attach(GameSimulation* game, bool isResumed)
+{
+	_isMuted = isResumed;
+	game->AddEventListener(this);
+	_isMuted = false;
+}
+
+void MoveJournal::OnGameStarted(const GameBoard& gameBoard)
+{
+	(void)gameBoard;
+	Append(RecordType::Reset, { kInvalidPlayerID, { 0, 0 } });
+}
+
+void MoveJournal::OnMoveApplied(const PlayerMove& move)
+{
+	Append(RecordType::Mark, move);
+}
+
+void MoveJournal::OnMoveReverted(const PlayerMove& move)
+{
+	Append(RecordType::Undo, move);
+}
+
+void MoveJournal::OnSeek(const GameBoard& gameBoard, const std::vector<PlayerMove>& moves, bool isUndo)
+{
+	(void)gameBoard;
+	AppendMoves(isUndo ? RecordType::Undo : RecordType::Mark, moves);
+}
+
+void MoveJournal::Append(RecordType type, const PlayerMove& move)
+{
+	assert(_syncThread.joinable());
+	if (_isMuted)
+	{
+		return;
+	}
+
+	const Record record = { type, static_cast<uint8_t>(move.playerID), move.position.x, move.position.y, 0 };
+	{
+		std::lock_guard<std::mutex> lock(_mutex);
+		_pendingRecords.push_back(record);
+	}
+	_condition.notify_one();
+}
+
+void MoveJournal::AppendMoves(RecordType type, const std::vector<PlayerMove>& moves)
+{
+	assert(_syncThread.joinable());
+	if (_isMuted || moves.empty())
+	{
+		return;
+	}
+
+	// The whole batch goes in under one lock, so the sync thread wakes up once for it.
+	{
+		std::lock_guard<std::mutex> lock(_mutex);
+		for (const PlayerMove& move : moves)
+		{
+			_pendingRecords.push_back({ type, static_cast<uint8_t>(move.playerID), move.position.x, move.position.y, 0 });
+		}
+	}
+	_condition.notify_one();
+}
+
+void MoveJournal::SyncThreadMain()
+{
+	// Once a write fails the file may end part way through a record, so nothing more is written after it.
+	bool isFileValid = true;
+
+	std::unique_lock<std::mutex> lock(_mutex);
+	for (;;)
+	{
+		_condition.wait(lock, [this]() { return !_pendingRecords.empty() || _isClosing; });
+		if (_pendingRecords.empty())
+		{
+			break;
+		}
+
+		// Everything appended while this batch is being written & synced makes up the next one.
+		_syncRecords.swap(_pendingRecords);
+		lock.unlock();
+
+		if (isFileValid)
+		{
+			isFileValid = WriteJournalFile(_syncRecords.data(), _syncRecords.size() * sizeof(Record)) && SyncJournalFile();
+		}
+		_syncRecords.clear();
+
+		lock.lock();
+	}
+}
+
+#ifdef _WIN32
+
+bool MoveJournal::OpenJournalFile(const char* path, uint64_t* outFileSize)
+{
+	_fileHandle = CreateFileA(path, GENERIC_READ | GENERIC_WRITE, FILE_SHARE_READ, nullptr, OPEN_ALWAYS, FILE_ATTRIBUTE_NORMAL, nullptr);
+	LARGE_INTEGER fileSize;
+	if (_fileHandle == INVALID_HANDLE_VALUE || !GetFileSizeEx(_fileHandle, &fileSize))
+	{
+		CloseJournalFile();
+		return false;
+	}
+
+	*outFileSize = static_cast<uint64_t>(fileSize.QuadPart);
+	return true;
+}
+
+bool MoveJournal::ReadJournalFile(void* data, size_t size)
+{
+	DWORD bytesRead;
+	return ReadFile(_fileHandle, data, static_cast<DWORD>(size), &bytesRead, nullptr) && bytesRead == size;
+}
+
+bool MoveJournal::TruncateJournalFile(uint64_t size)
+{
+	LARGE_INTEGER position;
+	position.QuadPart = static_cast<long long>(size);
+	return SetFilePointerEx(_fileHandle, position, nullptr, FILE_BEGIN) && SetEndOfFile(_fileHandle);
+}
+
+bool MoveJournal::WriteJournalFile(const void* data, size_t size)
+{
+	DWORD bytesWritten;
+	return WriteFile(_fileHandle, data, static_cast<DWORD>(size), &bytesWritten, nullptr) && bytesWritten == size;
+}
+
+bool MoveJournal::SyncJournalFile()
+{
+	return FlushFileBuffers(_fileHandle) != FALSE;
+}
+
+void MoveJournal::CloseJournalFile()
+{
+	if (_fileHandle != INVALID_HANDLE_VALUE)
+	{
+		CloseHandle(_fileHandle);
+		_fileHandle = INVALID_HANDLE_VALUE;
+	}
+}
+
+#else
+
+bool MoveJournal::OpenJournalFile(const char* path, uint64_t* outFileSize)
+{
+	_fileDescriptor = open(path, O_RDWR | O_CREAT, 0644);
+	struct stat fileStat;
+	if (_fileDescriptor < 0 || fstat(_fileDescriptor, &fileStat) != 0)
+	{
+		CloseJournalFile();
+		return false;
+	}
+
+	*outFileSize = static_cast<uint64_t>(fileStat.st_size);
+	return true;
+}
+
+bool MoveJournal::ReadJournalFile(void* data, size_t size)
+{
+	return read(_fileDescriptor, data, size) == static_cast<ssize_t>(size);
+}
+
+bool MoveJournal::TruncateJournalFile(uint64_t size)
+{
+	return ftruncate(_fileDescriptor, static_cast<off_t>(size)) == 0 &&
+		lseek(_fileDescriptor, static_cast<off_t>(size), SEEK_SET) == static_cast<off_t>(size);
+}
+
+bool MoveJournal::WriteJournalFile(const void* data, size_t size)
+{
+	return write(_fileDescriptor, data, size) == static_cast<ssize_t>(size);
+}
+
+bool MoveJournal::SyncJournalFile()
+{
+	return fsync(_fileDescriptor) == 0;
+}
+
+void MoveJournal::CloseJournalFile()
+{
+	if (_fileDescriptor >= 0)
+	{
+		close(_fileDescriptor);
+		_fileDescriptor = -1;
+	}
+}
+
+#endif
@@ -0,0 +1,126 @@
+#pragma once
+
+#include "GameEventListener.h"
+
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace tictactoe
+{
+	class GameSimulation;
+
+	// The move journal format.
+	//
+	// A file starts with a Header, followed by fixed-size Records in the order the changes were made. Each record is
+	// appended whole, so a crash can at most leave a partial record at the end, which is dropped (see Open()).
+	namespace MoveJournalFormat
+	{
+		static const uint8_t kMagic[4] = { 'M', 'N', 'K', 'J' };
+		static const uint16_t kVersion = 1;
+
+		enum class RecordType : uint8_t
+		{
+			None = 0,
+			Reset,
+			Mark,
+			Undo,
+
+			Count
+		};
+
+		struct Header
+		{
+			uint8_t magic[4];
+			uint16_t version;
+			uint16_t columns;
+			uint16_t rows;
+			uint16_t winCondition;
+		};
+
+		struct Record
+		{
+			RecordType type;
+			uint8_t playerID;
+			uint16_t x;
+			uint16_t y;
+			uint16_t reserved;
+		};
+
+		static_assert(sizeof(Header) == 12, "The journal header must have no padding.");
+		static_assert(sizeof(Record) == 8, "Journal records must have no padding.");
+	}
+
+	// A write-ahead journal of every change made to a GameSimulation, so that a session can be resumed after the
+	// process dies (see Replay()).
+	//
+	// Each change appends a record to an in-memory batch; a background thread writes the batch to the file and syncs
+	// it to disk, with whatever was appended in the meantime becoming the next batch. Playing a move therefore never
+	// waits on the disk. Undos are journaled as such, while redos & jumps are journaled as the moves they apply; a
+	// replayed Mark of a move that could be redone simply redoes it, so the whole move history is rebuilt.
+	class MoveJournal : public GameEventListener
+	{
+	public:
+		// Reads the board size of an existing journal, so that a game can be created to replay it into.
+		static bool ReadBoardSize(const char* path, uint16_t* outM, uint16_t* outN, uint16_t* outK);
+
+		// Brings a new game to the state at the end of the journal. Only the records after the last reset are read,
+		// since a reset clears everything before it. Returns false if the journal is missing or invalid, or doesn't
+		// match the game.
+		static bool Replay(const char* path, GameSimulation* game);
+
+	public:
+		MoveJournal();
+		virtual ~MoveJournal();
+
+		MoveJournal(const MoveJournal&) = delete;
+		MoveJournal& operator=(const MoveJournal&) = delete;
+
+		// Opens the journal of a m,n,k game to append to, creating it if need be. An existing journal must be for the
+		// same board size.
+		bool Open(const char* path, uint16_t m, uint16_t n, uint16_t k);
+
+		// Writes & syncs any outstanding records, then closes the file.
+		void Close();
+
+		// Starts journaling the game. A resumed game already holds what the journal ends in (see Replay()), so only
+		// the changes after this are journaled; otherwise the game's current state is journaled first.
+		void Attach(GameSimulation* game, bool isResumed);
+
+		virtual void OnGameStarted(const GameBoard& gameBoard) override;
+		virtual void OnMoveApplied(const PlayerMove& move) override;
+		virtual void OnMoveReverted(const PlayerMove& move) override;
+		virtual void OnSeek(const GameBoard& gameBoard, const std::vector<PlayerMove>& moves, bool isUndo) override;
+
+	private:
+		void Append(MoveJournalFormat::RecordType type, const PlayerMove& move);
+		void AppendMoves(MoveJournalFormat::RecordType type, const std::vector<PlayerMove>& moves);
+		void SyncThreadMain();
+
+		bool OpenJournalFile(const char* path, uint64_t* outFileSize);
+		bool ReadJournalFile(void* data, size_t size);
+		bool TruncateJournalFile(uint64_t size);
+		bool WriteJournalFile(const void* data, size_t size);
+		bool SyncJournalFile();
+		void CloseJournalFile();
+
+		std::mutex _mutex;
+		std::condition_variable _condition;
+		std::vector<MoveJournalFormat::Record> _pendingRecords;
+		bool _isClosing;
+		bool _isMuted;
+
+		// Only used by the sync thread.
+		std::vector<MoveJournalFormat::Record> _syncRecords;
+		std::thread _syncThread;
+
+#ifdef _WIN32
+		void* _fileHandle;
+#else
+		int _fileDescriptor;
+#endif
+	};
+}
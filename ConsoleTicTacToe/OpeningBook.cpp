@@ -0,0 +1,319 @@
+#include "OpeningBook.h"
+
+#include "GameRecord.h"
+
+#include <algorithm>
+#include <cassert>
+#include <chrono>
+#include <cstring>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <vector>
+
+using namespace tictactoe;
+using namespace tictactoe::OpeningBookFormat;
+
+// After this many steps a search bisects instead, so that a badly skewed range can't make it linear.
+static const uint32_t kMaxInterpolationSteps = 8;
+
+// A move played from a position in a recorded game, and how that game turned out for the player who made it.
+struct BookMove
+{
+	uint64_t hash;
+	uint32_t move;		// The cell index on the canonical orientation of the board.
+	uint32_t points;	// In half-points: win = 2, draw = 1, loss = 0.
+};
+
+bool OpeningBook::Build(
+	const char* recordPath, uint16_t m, uint16_t n, uint16_t k, uint32_t maxPlyCount, uint32_t minGameCount,
+	const char* path)
+{
+	std::cout << "Opening book: " << m << "x" << n << ", " << k << "-in-a-row, first " << maxPlyCount << " moves" << std::endl;
+	const auto startTime = std::chrono::steady_clock::now();
+
+	MappedFile recordFile;
+	if (!recordFile.Open(recordPath))
+	{
+		std::cerr << "Error: Unable to open '" << recordPath << "'." << std::endl;
+		return false;
+	}
+
+	GameRecordReader reader(recordFile.GetData(), recordFile.GetSize());
+	if (!reader.IsValid())
+	{
+		std::cerr << "Error: '" << recordPath << "' is not a game record file." << std::endl;
+		return false;
+	}
+
+	// Replay the opening of every finished game of the right size. The frontier isn't needed for that.
+	GameBoard gameBoard(m, n, k, 2, 0);
+	std::vector<BookMove> bookMoves;
+	std::vector<uint32_t> moves;
+	uint64_t gameCount = 0;
+	GameRecord record;
+	while (reader.ReadNext(&record))
+	{
+		if (record.columns != m || record.rows != n || record.winCondition != k || record.numPlayers != 2)
+		{
+			continue;
+		}
+
+		GameRecordReader::ReadFinalLine(record, &moves);
+		gameBoard.Clear();
+
+		const size_t firstBookMove = bookMoves.size();
+		bool isValid = true;
+		for (size_t ply = 0; ply < moves.size() && isValid; ply++)
+		{
+			const PlayerID playerID = static_cast<PlayerID>(ply % 2);
+			const BoardPosition position = gameBoard.GetCellPosition(moves[ply]);
+			if (!gameBoard.IsValidPosition(position))
+			{
+				isValid = false;
+				break;
+			}
+
+			if (ply < maxPlyCount)
+			{
+				const BoardSymmetry symmetry = gameBoard.GetCanonicalSymmetry();
+				const BoardPosition canonicalPosition = gameBoard.TransformPosition(position, symmetry);
+				bookMoves.push_back({ gameBoard.GetSymmetryHash(symmetry), gameBoard.GetCellIndex(canonicalPosition), 0 });
+			}
+			isValid = (gameBoard.Mark(playerID, position) == MarkResult::Success);
+		}
+
+		// Games that were abandoned part way through have no result to learn from.
+		const PlayerID winningPlayer = gameBoard.GetWinningPlayer();
+		if (!isValid || (winningPlayer == kInvalidPlayerID && !gameBoard.IsFilled()))
+		{
+			bookMoves.resize(firstBookMove);
+			continue;
+		}
+
+		for (size_t i = firstBookMove; i < bookMoves.size(); i++)
+		{
+			const PlayerID playerID = static_cast<PlayerID>((i - firstBookMove) % 2);
+			bookMoves[i].points = (winningPlayer == kInvalidPlayerID) ? 1 : (winningPlayer == playerID) ? 2 : 0;
+		}
+		gameCount++;
+	}
+
+	std::sort(bookMoves.begin(), bookMoves.end(), [](const BookMove& a, const BookMove& b)
+	{
+		return (a.hash != b.hash) ? (a.hash < b.hash) : (a.move < b.move);
+	});
+
+	// Pick the best move of each position that came up often enough. Scores are smoothed towards a draw (as if
+	// every move had also been drawn once), so that a move that won the only game it was tried in doesn't beat
+	// one that won most of many.
+	std::vector<Entry> entries;
+	uint64_t positionCount = 0;
+	for (size_t first = 0; first < bookMoves.size(); )
+	{
+		size_t last = first;
+		while (last < bookMoves.size() && bookMoves[last].hash == bookMoves[first].hash)
+		{
+			last++;
+		}
+		positionCount++;
+
+		uint64_t bestCount = 0;
+		uint64_t bestPoints = 0;
+		uint32_t bestMove = 0;
+		for (size_t i = first; i < last; )
+		{
+			uint64_t count = 0;
+			uint64_t points = 0;
+			const uint32_t move = bookMoves[i].move;
+			for (; i < last && bookMoves[i].move == move; i++)
+			{
+				count++;
+				points += bookMoves[i].points;
+			}
+
+			// (points + 1) / (2 * count + 2) against the best so far, without dividing.
+			const uint64_t score = (points + 1) * ((2 * bestCount) + 2);
+			const uint64_t bestScore = (bestPoints + 1) * ((2 * count) + 2);
+			if (bestCount == 0 || score > bestScore || (score == bestScore && count > bestCount))
+			{
+				bestCount = count;
+				bestPoints = points;
+				bestMove = move;
+			}
+		}
+
+		if (last - first >= minGameCount)
+		{
+			const BoardPosition position = gameBoard.GetCellPosition(bestMove);
+			entries.push_back({
+				bookMoves[first].hash,
+				position.x,
+				position.y,
+				static_cast<uint16_t>(std::min<uint64_t>(bestCount, UINT16_MAX)),
+				static_cast<uint16_t>((bestPoints * kMaxScore) / (2 * bestCount)) });
+		}
+		first = last;
+	}
+
+	Header header = {};
+	memcpy(header.magic, kMagic, sizeof(kMagic));
+	header.version = kVersion;
+	header.columns = m;
+	header.rows = n;
+	header.winCondition = k;
+	header.entryCount = entries.size();
+
+	std::ofstream file(path, std::ios::binary | std::ios::trunc);
+	file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+	file.write(reinterpret_cast<const char*>(entries.data()), entries.size() * sizeof(Entry));
+	file.close();
+	if (!file)
+	{
+		std::cerr << "Error: Unable to write the opening book to '" << path << "'." << std::endl;
+		return false;
+	}
+
+	const double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - startTime).count();
+	std::cout
+		<< std::left << std::setw(20) << "Games" << std::right << std::setw(12) << gameCount << std::endl
+		<< std::left << std::setw(20) << "Positions" << std::right << std::setw(12) << positionCount << std::endl
+		<< std::left << std::setw(20) << "Book entries" << std::right << std::setw(12) << entries.size() << std::endl
+		<< std::fixed << std::setprecision(2)
+		<< std::left << std::setw(20) << "Seconds" << std::right << std::setw(12) << seconds << std::endl;
+	return true;
+}
+
+OpeningBook::OpeningBook() :
+	_columns(0),
+	_rows(0),
+	_winCondition(0),
+	_file(),
+	_entries(nullptr),
+	_entryCount(0)
+{
+}
+
+bool OpeningBook::Open(const char* path)
+{
+	Close();
+	if (!_file.Open(path) || _file.GetSize() < sizeof(Header))
+	{
+		Close();
+		return false;
+	}
+
+	Header header;
+	memcpy(&header, _file.GetData(), sizeof(header));
+	if (memcmp(header.magic, kMagic, sizeof(kMagic)) != 0 || header.version != kVersion ||
+		header.entryCount > (_file.GetSize() - sizeof(Header)) / sizeof(Entry))
+	{
+		Close();
+		return false;
+	}
+
+	_columns = header.columns;
+	_rows = header.rows;
+	_winCondition = header.winCondition;
+	_entries = reinterpret_cast<const Entry*>(_file.GetData() + sizeof(Header));
+	_entryCount = header.entryCount;
+	return true;
+}
+
+void OpeningBook::Close()
+{
+	_file.Close();
+	_entries = nullptr;
+	_entryCount = 0;
+}
+
+bool OpeningBook::TryGetMove(const GameBoard& gameBoard, BoardPosition* outPosition) const
+{
+	if (_entries == nullptr || gameBoard.GetColumns() != _columns || gameBoard.GetRows() != _rows ||
+		gameBoard.GetWinCondition() != _winCondition || gameBoard.GetNumPlayers() != 2 ||
+		gameBoard.GetWinningPlayer() != kInvalidPlayerID || gameBoard.IsFilled())
+	{
+		return false;
+	}
+
+	const BoardSymmetry symmetry = gameBoard.GetCanonicalSymmetry();
+	const Entry* entry = FindEntry(gameBoard.GetSymmetryHash(symmetry));
+	if (entry == nullptr)
+	{
+		return false;
+	}
+
+	// The move is on the canonical orientation of the board, so it's mapped back onto this one. A corrupt entry (or
+	// a hash collision) could still name a cell that isn't free.
+	const BoardPosition canonicalPosition = { entry->x, entry->y };
+	if (!gameBoard.IsValidPosition(canonicalPosition))
+	{
+		return false;
+	}
+	const BoardPosition position = gameBoard.TransformPosition(canonicalPosition, GameBoard::GetInverseSymmetry(symmetry));
+	if (gameBoard.GetMarker(position) != kInvalidPlayerID)
+	{
+		return false;
+	}
+
+	*outPosition = position;
+	return true;
+}
+
+// Hashes are uniformly distributed, so interpolating between the hashes at the ends of the range usually lands
+// within a few entries of the one searched for.
+// See https://en.wikipedia.org/wiki/Interpolation_search
+const Entry* OpeningBook::FindEntry(uint64_t hash) const
+{
+	if (_entryCount == 0)
+	{
+		return nullptr;
+	}
+
+	uint64_t low = 0;
+	uint64_t high = _entryCount - 1;
+	for (uint32_t step = 0; low <= high; step++)
+	{
+		const uint64_t lowHash = _entries[low].hash;
+		const uint64_t highHash = _entries[high].hash;
+		if (hash < lowHash || hash > highHash)
+		{
+			return nullptr;
+		}
+
+		uint64_t middle;
+		if (lowHash == highHash)
+		{
+			middle = low;
+		}
+		else if (step < kMaxInterpolationSteps)
+		{
+			const double fraction = static_cast<double>(hash - lowHash) / static_cast<double>(highHash - lowHash);
+			middle = low + static_cast<uint64_t>(fraction * static_cast<double>(high - low));
+		}
+		else
+		{
+			middle = low + ((high - low) / 2);
+		}
+		assert(middle >= low && middle <= high);
+
+		const uint64_t middleHash = _entries[middle].hash;
+		if (middleHash == hash)
+		{
+			return &_entries[middle];
+		}
+		if (middleHash < hash)
+		{
+			low = middle + 1;
+		}
+		else
+		{
+			if (middle == 0)
+			{
+				return nullptr;
+			}
+			high = middle - 1;
+		}
+	}
+	return nullptr;
+}
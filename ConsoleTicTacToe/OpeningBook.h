@@ -0,0 +1,87 @@
+#pragma once
+
+#include "GameBoard.h"
+#include "MappedFile.h"
+
+#include <cstdint>
+
+namespace tictactoe
+{
+	// The opening book file format.
+	//
+	// A file is a Header followed by one Entry per position, sorted by the position's canonical hash (see
+	// GameBoard::GetCanonicalHash()) so that it can be searched in place. Each entry's move is given on the
+	// canonical orientation of the board, which makes it apply to every reflection & rotation of the position.
+	namespace OpeningBookFormat
+	{
+		static const uint8_t kMagic[4] = { 'M', 'N', 'K', 'B' };
+		static const uint16_t kVersion = 1;
+
+		struct Header
+		{
+			uint8_t magic[4];
+			uint16_t version;
+			uint16_t columns;
+			uint16_t rows;
+			uint16_t winCondition;
+			uint32_t reserved;
+			uint64_t entryCount;
+		};
+
+		struct Entry
+		{
+			uint64_t hash;
+			uint16_t x;
+			uint16_t y;
+			uint16_t gameCount;		// The number of games the move was played in (saturated at UINT16_MAX).
+			uint16_t score;			// The move's expected score in those games, from 0 (lost) to kMaxScore (won).
+		};
+
+		static const uint16_t kMaxScore = 1000;
+
+		static_assert(sizeof(Header) == 24, "The opening book header must have no padding.");
+		static_assert(sizeof(Entry) == 16, "Opening book entries must have no padding.");
+	}
+
+	// The best-scoring move of the opening positions of a corpus of recorded games, memory-mapped so that opening
+	// a book doesn't read it and a lookup only touches the few entries an interpolation search visits.
+	class OpeningBook
+	{
+	public:
+		// Builds a book for m,n,k boards from the games of that size in the given record file (see
+		// GameRecordWriter): every position within the first maxPlyCount moves that was reached in at least
+		// minGameCount games gets the move with the best (smoothed) score from them. Prints a summary.
+		static bool Build(
+			const char* recordPath, uint16_t m, uint16_t n, uint16_t k, uint32_t maxPlyCount, uint32_t minGameCount,
+			const char* path);
+
+	public:
+		OpeningBook();
+
+		OpeningBook(const OpeningBook&) = delete;
+		OpeningBook& operator=(const OpeningBook&) = delete;
+
+		bool Open(const char* path);
+		void Close();
+
+		bool IsOpen() const { return _entries != nullptr; }
+		uint16_t GetColumns() const { return _columns; }
+		uint16_t GetRows() const { return _rows; }
+		uint16_t GetWinCondition() const { return _winCondition; }
+		uint64_t GetEntryCount() const { return _entryCount; }
+
+		// Returns false if the board isn't the book's size or the position isn't in the book.
+		bool TryGetMove(const GameBoard& gameBoard, BoardPosition* outPosition) const;
+
+	private:
+		const OpeningBookFormat::Entry* FindEntry(uint64_t hash) const;
+
+		uint16_t _columns;
+		uint16_t _rows;
+		uint16_t _winCondition;
+
+		MappedFile _file;
+		const OpeningBookFormat::Entry* _entries;
+		uint64_t _entryCount;
+	};
+}
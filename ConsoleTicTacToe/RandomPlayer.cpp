@@ -0,0 +1,20 @@
+#include "RandomPlayer.h"
+
+using namespace tictactoe;
+
+RandomPlayer::RandomPlayer(uint64_t seed) :
+	// xorshift gets stuck on a zero state.
+	_randomState(seed != 0 ? seed : 0x9E3779B97F4A7C15ull)
+{
+}
+
+RandomPlayer::~RandomPlayer()
+{
+}
+
+BoardPosition RandomPlayer::SearchMove(GameBoard& gameBoard, PlayerID playerID)
+{
+	(void)playerID;
+	const uint32_t move = GetRandomCandidateMove(gameBoard, IsFrontierSearch(gameBoard), NextRandom(_randomState));
+	return gameBoard.GetCellPosition(move);
+}
@@ -0,0 +1,20 @@
+#pragma once
+
+#include "AIPlayer.h"
+
+namespace tictactoe
+{
+	// A computer player that picks uniformly among the candidate moves; a baseline opponent for self-play.
+	class RandomPlayer : public AIPlayer
+	{
+	public:
+		explicit RandomPlayer(uint64_t seed);
+		virtual ~RandomPlayer();
+
+	protected:
+		virtual BoardPosition SearchMove(GameBoard& gameBoard, PlayerID playerID) override;
+
+	private:
+		uint64_t _randomState;
+	};
+}
@@ -0,0 +1,130 @@
+#include "SelfPlay.h"
+
+#include "GameRecord.h"
+#include "HeadlessGame.h"
+#include "WorkStealingPool.h"
+
+#include <chrono>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <vector>
+
+using namespace tictactoe;
+
+// The results of the games played by a single worker thread.
+struct SelfPlayResults
+{
+	uint64_t gameCount;
+	uint64_t winCounts[GameSimulation::kNumPlayers];
+	uint64_t drawCount;
+	uint64_t moveCount;
+};
+
+static void sPrintResultLine(const char* name, uint64_t count, uint64_t gameCount);
+
+void tictactoe::RunSelfPlay(
+	uint16_t m, uint16_t n, uint16_t k, uint64_t gameCount, uint16_t threadCount,
+	const SelfPlayPlayer (&players)[GameSimulation::kNumPlayers], std::ostream* recordStream)
+{
+	std::cout << "Self-play: " << m << "x" << n << ", " << k << "-in-a-row, ";
+	std::cout << gameCount << (gameCount == 1 ? " game on " : " games on ");
+	std::cout << threadCount << (threadCount == 1 ? " thread (" : " threads (");
+	for (PlayerID playerID = 0; playerID < GameSimulation::kNumPlayers; playerID++)
+	{
+		std::cout << (playerID > 0 ? " vs " : "") << players[playerID].name;
+	}
+	std::cout << ")" << std::endl;
+
+	// Every worker gets its own game & players up front, so that playing a game never allocates a new board.
+	const uint64_t seed = static_cast<uint64_t>(std::chrono::steady_clock::now().time_since_epoch().count());
+	std::vector<std::unique_ptr<HeadlessGame>> games;
+	std::vector<std::unique_ptr<GameRecordWriter>> recordWriters;
+	std::mutex recordStreamMutex;
+	for (uint16_t i = 0; i < threadCount; i++)
+	{
+		games.push_back(std::make_unique<HeadlessGame>(m, n, k));
+		if (recordStream != nullptr)
+		{
+			recordWriters.push_back(std::make_unique<GameRecordWriter>(*recordStream, &recordStreamMutex));
+			games[i]->AddEventListener(recordWriters[i].get());
+		}
+		for (PlayerID playerID = 0; playerID < GameSimulation::kNumPlayers; playerID++)
+		{
+			const uint64_t playerSeed = seed + (((i * GameSimulation::kNumPlayers) + playerID + 1) * 0x9E3779B97F4A7C15ull);
+			games[i]->SetAIPlayer(playerID, players[playerID].createPlayer(playerSeed));
+		}
+	}
+
+	std::vector<SelfPlayResults> results(threadCount, SelfPlayResults());
+	const auto startTime = std::chrono::steady_clock::now();
+
+	WorkStealingPool pool(threadCount);
+	pool.Run(gameCount, [&games, &results](uint16_t workerIndex, uint64_t gameIndex)
+	{
+		(void)gameIndex;
+		HeadlessGame& game = *games[workerIndex];
+		SelfPlayResults& workerResults = results[workerIndex];
+
+		game.Reset();
+		if (game.PlayToEnd() == GameStatus::Won)
+		{
+			workerResults.winCounts[game.GetWinningPlayer()]++;
+		}
+		else
+		{
+			workerResults.drawCount++;
+		}
+		workerResults.gameCount++;
+		workerResults.moveCount += game.GetMoveHistory().GetAvailableUndosCount();
+	});
+
+	// Writing out the last records is part of the work, so it's timed too.
+	for (std::unique_ptr<GameRecordWriter>& recordWriter : recordWriters)
+	{
+		recordWriter->EndRecord();
+	}
+	const double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - startTime).count();
+
+	SelfPlayResults totals = {};
+	for (const SelfPlayResults& workerResults : results)
+	{
+		totals.gameCount += workerResults.gameCount;
+		for (PlayerID playerID = 0; playerID < GameSimulation::kNumPlayers; playerID++)
+		{
+			totals.winCounts[playerID] += workerResults.winCounts[playerID];
+		}
+		totals.drawCount += workerResults.drawCount;
+		totals.moveCount += workerResults.moveCount;
+	}
+
+	for (PlayerID playerID = 0; playerID < GameSimulation::kNumPlayers; playerID++)
+	{
+		const std::string name = std::string(GameSimulation::GetPlayerName(playerID)) + " wins";
+		sPrintResultLine(name.c_str(), totals.winCounts[playerID], totals.gameCount);
+	}
+	sPrintResultLine("Draws", totals.drawCount, totals.gameCount);
+
+	const double gamesPerSecond = totals.gameCount / ((seconds > 0.0) ? seconds : 1.0);
+	std::cout
+		<< std::fixed << std::setprecision(2)
+		<< std::left << std::setw(20) << "Moves per game" << std::right
+		<< std::setw(12) << (static_cast<double>(totals.moveCount) / ((totals.gameCount > 0) ? totals.gameCount : 1)) << std::endl
+		<< std::left << std::setw(20) << "Seconds" << std::right
+		<< std::setw(12) << seconds << std::endl
+		<< std::setprecision(0)
+		<< std::left << std::setw(20) << "Games/s" << std::right
+		<< std::setw(12) << gamesPerSecond << std::endl
+		<< std::left << std::setw(20) << "Games/s/thread" << std::right
+		<< std::setw(12) << (gamesPerSecond / threadCount) << std::endl;
+}
+
+static void sPrintResultLine(const char* name, uint64_t count, uint64_t gameCount)
+{
+	std::cout
+		<< std::left << std::setw(20) << name << std::right
+		<< std::setw(12) << count
+		<< std::fixed << std::setprecision(2)
+		<< std::setw(9) << ((100.0 * count) / ((gameCount > 0) ? gameCount : 1)) << "%"
+		<< std::endl;
+}
@@ -0,0 +1,28 @@
+#pragma once
+
+#include "AIPlayer.h"
+#include "GameSimulation.h"
+
+#include <cstdint>
+#include <functional>
+#include <iosfwd>
+#include <memory>
+
+namespace tictactoe
+{
+	// Creates one of the players for a self-play worker thread; seed differs between every player created.
+	typedef std::function<std::unique_ptr<AIPlayer>(uint64_t seed)> SelfPlayPlayerFactory;
+
+	struct SelfPlayPlayer
+	{
+		const char* name;
+		SelfPlayPlayerFactory createPlayer;
+	};
+
+	// Plays gameCount games between the given players on a WorkStealingPool with threadCount threads, each of which
+	// runs its own HeadlessGame one game at a time, then prints the win / draw statistics and games per second.
+	// Every game is also appended to recordStream (see GameRecordWriter) if one is given.
+	void RunSelfPlay(
+		uint16_t m, uint16_t n, uint16_t k, uint64_t gameCount, uint16_t threadCount,
+		const SelfPlayPlayer (&players)[GameSimulation::kNumPlayers], std::ostream* recordStream);
+}
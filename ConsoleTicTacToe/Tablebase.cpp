@@ -0,0 +1,516 @@
+#include "Tablebase.h"
+
+#include "FixedGameBoard.h"
+#include "WorkStealingPool.h"
+
+#include <cassert>
+#include <chrono>
+#include <cstring>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+
+using namespace tictactoe;
+using namespace tictactoe::TablebaseFormat;
+
+static uint8_t sMakeEntry(TablebaseValue value, uint32_t distance)
+{
+	assert(distance <= kDistanceMask);
+	return static_cast<uint8_t>((static_cast<uint32_t>(value) << kValueShift) | distance);
+}
+
+static TablebaseValue sGetValue(uint8_t entry)
+{
+	return static_cast<TablebaseValue>(entry >> kValueShift);
+}
+
+// The first pass marks every reachable position with this, before the second pass solves them.
+static const uint8_t kReachableEntry = sMakeEntry(TablebaseValue::Draw, 0);
+
+// Player 1 makes every odd-numbered move, so the number of markers decides both how many each player has and whose
+// turn it is.
+static uint32_t sGetMarkerCount(uint32_t markerCount, PlayerID playerID)
+{
+	return (playerID == 0) ? ((markerCount + 1) / 2) : (markerCount / 2);
+}
+
+static PlayerID sGetPlayerToMove(uint32_t markerCount)
+{
+	return static_cast<PlayerID>(markerCount % 2);
+}
+
+bool Tablebase::IsSupported(uint16_t m, uint16_t n, uint16_t k)
+{
+	return static_cast<uint32_t>(m) * n <= kMaxCellCount && k > 0;
+}
+
+bool Tablebase::Build(uint16_t m, uint16_t n, uint16_t k, uint16_t threadCount, const char* path)
+{
+	assert(IsSupported(m, n, k));
+
+	std::cout << "Tablebase: " << m << "x" << n << ", " << k << "-in-a-row on ";
+	std::cout << threadCount << (threadCount == 1 ? " thread" : " threads") << std::endl;
+	const auto startTime = std::chrono::steady_clock::now();
+
+	Tablebase tablebase;
+	tablebase.Initialize(m, n, k);
+	std::vector<uint8_t> entries(static_cast<size_t>(tablebase.GetPositionCount()));
+
+	// Every move adds a marker, so positions only lead to ones with one more marker. Each layer of positions with
+	// the same marker count can therefore be done in parallel, once the layer it depends on is done: first forwards
+	// from the empty board to find the reachable positions, then backwards from the full board to solve them.
+	// Each task is every position with one particular set of player 1 markers.
+	WorkStealingPool pool(threadCount);
+	for (uint32_t markerCount = 0; markerCount <= tablebase._cellCount; markerCount++)
+	{
+		pool.Run(tablebase._binomials[tablebase._cellCount][sGetMarkerCount(markerCount, 0)], [&](uint16_t, uint64_t xRank)
+		{
+			tablebase.ForEachPosition(markerCount, xRank, [&](uint64_t index, const uint32_t (&masks)[2])
+			{
+				entries[index] = tablebase.FindReachability(markerCount, masks, entries.data());
+			});
+		});
+	}
+	for (uint32_t markerCount = tablebase._cellCount + 1; markerCount-- > 0; )
+	{
+		pool.Run(tablebase._binomials[tablebase._cellCount][sGetMarkerCount(markerCount, 0)], [&](uint16_t, uint64_t xRank)
+		{
+			tablebase.ForEachPosition(markerCount, xRank, [&](uint64_t index, const uint32_t (&masks)[2])
+			{
+				if (entries[index] != 0)
+				{
+					entries[index] = tablebase.Solve(markerCount, masks, entries.data());
+				}
+			});
+		});
+	}
+
+	Header header = {};
+	memcpy(header.magic, kMagic, sizeof(kMagic));
+	header.version = kVersion;
+	header.columns = m;
+	header.rows = n;
+	header.winCondition = k;
+	header.positionCount = tablebase.GetPositionCount();
+
+	std::ofstream file(path, std::ios::binary | std::ios::trunc);
+	file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+	file.write(reinterpret_cast<const char*>(entries.data()), entries.size());
+	file.close();
+	if (!file)
+	{
+		return false;
+	}
+
+	uint64_t valueCounts[static_cast<size_t>(TablebaseValue::Count)] = {};
+	for (uint8_t entry : entries)
+	{
+		valueCounts[static_cast<size_t>(sGetValue(entry))]++;
+	}
+	const TablebaseValue emptyBoardValue = sGetValue(entries[0]);
+	const double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - startTime).count();
+
+	std::cout
+		<< std::left << std::setw(20) << "Positions" << std::right << std::setw(12) << entries.size() << std::endl
+		<< std::left << std::setw(20) << "Reachable" << std::right << std::setw(12) << (entries.size() - valueCounts[0]) << std::endl
+		<< std::left << std::setw(20) << "Wins" << std::right << std::setw(12) << valueCounts[static_cast<size_t>(TablebaseValue::Win)] << std::endl
+		<< std::left << std::setw(20) << "Draws" << std::right << std::setw(12) << valueCounts[static_cast<size_t>(TablebaseValue::Draw)] << std::endl
+		<< std::left << std::setw(20) << "Losses" << std::right << std::setw(12) << valueCounts[static_cast<size_t>(TablebaseValue::Loss)] << std::endl
+		<< std::left << std::setw(20) << "Empty board" << std::right << std::setw(12)
+		<< ((emptyBoardValue == TablebaseValue::Win) ? "win" : (emptyBoardValue == TablebaseValue::Loss) ? "loss" : "draw") << std::endl
+		<< std::fixed << std::setprecision(2)
+		<< std::left << std::setw(20) << "Seconds" << std::right << std::setw(12) << seconds << std::endl;
+	return true;
+}
+
+Tablebase::Tablebase() :
+	_columns(0),
+	_rows(0),
+	_winCondition(0),
+	_cellCount(0),
+	_binomials(),
+	_layerOffsets(),
+	_lineMasks(),
+	_file(),
+	_entries(nullptr)
+{
+}
+
+bool Tablebase::Open(const char* path)
+{
+	Close();
+	if (!_file.Open(path) || _file.GetSize() < sizeof(Header))
+	{
+		Close();
+		return false;
+	}
+
+	Header header;
+	memcpy(&header, _file.GetData(), sizeof(header));
+	if (memcmp(header.magic, kMagic, sizeof(kMagic)) != 0 || header.version != kVersion ||
+		!IsSupported(header.columns, header.rows, header.winCondition))
+	{
+		Close();
+		return false;
+	}
+
+	Initialize(header.columns, header.rows, header.winCondition);
+	if (header.positionCount != GetPositionCount() || _file.GetSize() - sizeof(Header) < GetPositionCount())
+	{
+		Close();
+		return false;
+	}
+
+	_entries = _file.GetData() + sizeof(Header);
+	return true;
+}
+
+void Tablebase::Close()
+{
+	_file.Close();
+	_entries = nullptr;
+}
+
+bool Tablebase::Probe(const GameBoard& gameBoard, TablebaseEntry* outEntry) const
+{
+	uint32_t masks[2];
+	if (!TryGetMasks(gameBoard, masks))
+	{
+		return false;
+	}
+
+	*outEntry = GetEntry(GetIndex(masks));
+	return outEntry->value != TablebaseValue::Unknown;
+}
+
+bool Tablebase::ChooseMove(const GameBoard& gameBoard, PlayerID playerID, BoardPosition* outPosition, TablebaseEntry* outEntry) const
+{
+	uint32_t masks[2];
+	if (!TryGetMasks(gameBoard, masks) || sGetPlayerToMove(gameBoard.GetMarkerCount()) != playerID ||
+		gameBoard.GetWinningPlayer() != kInvalidPlayerID || gameBoard.IsFilled())
+	{
+		return false;
+	}
+
+	*outEntry = GetEntry(GetIndex(masks));
+	if (outEntry->value == TablebaseValue::Unknown)
+	{
+		return false;
+	}
+
+	// Rank each move by the result it leaves the opponent with: their fastest loss first, their slowest win last.
+	const uint32_t emptyMask = ~(masks[0] | masks[1]) & ((1u << _cellCount) - 1);
+	uint32_t bestCell = 0;
+	int32_t bestRank = -1;
+	for (uint32_t cell = 0; cell < _cellCount; cell++)
+	{
+		if ((emptyMask & (1u << cell)) == 0)
+		{
+			continue;
+		}
+
+		masks[playerID] |= (1u << cell);
+		const TablebaseEntry childEntry = GetEntry(GetIndex(masks));
+		masks[playerID] &= ~(1u << cell);
+
+		int32_t rank = 0;
+		switch (childEntry.value)
+		{
+			case TablebaseValue::Loss:	rank = 3 * (kDistanceMask + 1) - childEntry.distance; break;
+			case TablebaseValue::Draw:	rank = 2 * (kDistanceMask + 1); break;
+			case TablebaseValue::Win:	rank = 1 * (kDistanceMask + 1) + childEntry.distance; break;
+			default:					assert(false); break;
+		}
+		if (rank > bestRank)
+		{
+			bestRank = rank;
+			bestCell = cell;
+		}
+	}
+
+	*outPosition = gameBoard.GetCellPosition(bestCell);
+	return true;
+}
+
+void Tablebase::Initialize(uint16_t m, uint16_t n, uint16_t k)
+{
+	_columns = m;
+	_rows = n;
+	_winCondition = k;
+	_cellCount = static_cast<uint32_t>(m) * n;
+
+	for (uint32_t i = 0; i <= kMaxCellCount; i++)
+	{
+		_binomials[i][0] = 1;
+		for (uint32_t j = 1; j <= kMaxCellCount; j++)
+		{
+			_binomials[i][j] = (i == 0) ? 0 : (_binomials[i - 1][j - 1] + _binomials[i - 1][j]);
+		}
+	}
+
+	_layerOffsets[0] = 0;
+	for (uint32_t markerCount = 0; markerCount <= _cellCount; markerCount++)
+	{
+		const uint32_t xCount = sGetMarkerCount(markerCount, 0);
+		const uint32_t oCount = sGetMarkerCount(markerCount, 1);
+		_layerOffsets[markerCount + 1] = _layerOffsets[markerCount] +
+			(static_cast<uint64_t>(_binomials[_cellCount][xCount]) * _binomials[_cellCount - xCount][oCount]);
+	}
+
+	struct Offset
+	{
+		int32_t x;
+		int32_t y;
+	};
+	const Offset offsets[4] = { { 1, 0 }, { 0, 1 }, { 1, 1 }, { -1, 1 } };
+
+	_lineMasks.clear();
+	for (const Offset& offset : offsets)
+	{
+		for (int32_t y = 0; y < n; y++)
+		{
+			for (int32_t x = 0; x < m; x++)
+			{
+				const int32_t endX = x + ((k - 1) * offset.x);
+				const int32_t endY = y + ((k - 1) * offset.y);
+				if (endX < 0 || endX >= m || endY >= n)
+				{
+					continue;
+				}
+
+				uint32_t lineMask = 0;
+				for (int32_t step = 0; step < k; step++)
+				{
+					lineMask |= 1u << (((y + (step * offset.y)) * m) + x + (step * offset.x));
+				}
+				_lineMasks.push_back(lineMask);
+			}
+		}
+	}
+}
+
+bool Tablebase::TryGetMasks(const GameBoard& gameBoard, uint32_t* outMasks) const
+{
+	if (_entries == nullptr || gameBoard.GetColumns() != _columns || gameBoard.GetRows() != _rows ||
+		gameBoard.GetWinCondition() != _winCondition || gameBoard.GetNumPlayers() != 2)
+	{
+		return false;
+	}
+
+	outMasks[0] = 0;
+	outMasks[1] = 0;
+	for (uint32_t cell = 0; cell < _cellCount; cell++)
+	{
+		const PlayerID playerID = gameBoard.GetMarker(gameBoard.GetCellPosition(cell));
+		if (playerID != kInvalidPlayerID)
+		{
+			outMasks[playerID] |= (1u << cell);
+		}
+	}
+
+	// Only positions where player 1 moved first are indexed.
+	const uint32_t markerCount = gameBoard.GetMarkerCount();
+	return sCountBits(outMasks[0]) == sGetMarkerCount(markerCount, 0) &&
+		sCountBits(outMasks[1]) == sGetMarkerCount(markerCount, 1);
+}
+
+// Positions are ordered by marker count, then by the rank of player 1's cells among all sets of that many cells,
+// then by the rank of player 2's cells among the cells player 1 left empty. Sets of cells are ranked in
+// colexicographic order, i.e. the sum of C(cell, i) over the set's i-th lowest cell (counting from 1).
+uint64_t Tablebase::GetIndex(const uint32_t (&masks)[2]) const
+{
+	uint64_t xRank = 0;
+	uint64_t oRank = 0;
+	uint32_t xCount = 0;
+	uint32_t oCount = 0;
+	uint32_t emptyCount = 0;
+	for (uint32_t cell = 0; cell < _cellCount; cell++)
+	{
+		const uint32_t cellMask = 1u << cell;
+		if (masks[0] & cellMask)
+		{
+			xRank += _binomials[cell][++xCount];
+		}
+		else
+		{
+			if (masks[1] & cellMask)
+			{
+				oRank += _binomials[emptyCount][++oCount];
+			}
+			emptyCount++;
+		}
+	}
+	return _layerOffsets[xCount + oCount] + (xRank * _binomials[_cellCount - xCount][oCount]) + oRank;
+}
+
+bool Tablebase::HasLine(uint32_t mask) const
+{
+	for (uint32_t lineMask : _lineMasks)
+	{
+		if ((mask & lineMask) == lineMask)
+		{
+			return true;
+		}
+	}
+	return false;
+}
+
+TablebaseEntry Tablebase::GetEntry(uint64_t index) const
+{
+	const uint8_t entry = _entries[index];
+	return { sGetValue(entry), static_cast<uint8_t>(entry & kDistanceMask) };
+}
+
+// Calls func(index, masks) for every position with the given marker count and rank of player 1's cells, in index
+// order. Player 2's cells are stepped through with Gosper's hack over the cells player 1 left empty, which visits
+// the sets of that size in increasing (colexicographic) order.
+// See https://en.wikipedia.org/wiki/Combinatorial_number_system
+template<typename Func>
+void Tablebase::ForEachPosition(uint32_t markerCount, uint64_t xRank, Func&& func) const
+{
+	const uint32_t xCount = sGetMarkerCount(markerCount, 0);
+	const uint32_t oCount = sGetMarkerCount(markerCount, 1);
+
+	uint32_t masks[2] = { 0, 0 };
+	uint64_t remainingRank = xRank;
+	uint32_t cell = _cellCount;
+	for (uint32_t i = xCount; i > 0; i--)
+	{
+		do
+		{
+			cell--;
+		} while (_binomials[cell][i] > remainingRank);
+		masks[0] |= (1u << cell);
+		remainingRank -= _binomials[cell][i];
+	}
+
+	uint32_t emptyCells[kMaxCellCount];
+	uint32_t emptyCount = 0;
+	for (cell = 0; cell < _cellCount; cell++)
+	{
+		if ((masks[0] & (1u << cell)) == 0)
+		{
+			emptyCells[emptyCount++] = cell;
+		}
+	}
+
+	const uint64_t oSetCount = _binomials[emptyCount][oCount];
+	uint64_t index = _layerOffsets[markerCount] + (xRank * oSetCount);
+	uint32_t oSet = (1u << oCount) - 1;
+	for (uint64_t oRank = 0; oRank < oSetCount; oRank++, index++)
+	{
+		masks[1] = 0;
+		for (uint32_t i = 0; i < emptyCount; i++)
+		{
+			if (oSet & (1u << i))
+			{
+				masks[1] |= (1u << emptyCells[i]);
+			}
+		}
+		assert(GetIndex(masks) == index);
+		func(index, masks);
+
+		if (oSet != 0)
+		{
+			const uint32_t lowestBit = oSet & (~oSet + 1);
+			const uint32_t ripple = oSet + lowestBit;
+			oSet = ripple | (((oSet ^ ripple) / lowestBit) >> 2);
+		}
+	}
+}
+
+// A position is reachable if it's empty, or if taking back one of the last player's markers leaves a reachable
+// position in which the game wasn't already over.
+uint8_t Tablebase::FindReachability(uint32_t markerCount, const uint32_t (&masks)[2], const uint8_t* entries) const
+{
+	if (markerCount == 0)
+	{
+		return kReachableEntry;
+	}
+
+	// The other player's markers are the same in every parent, so if they have a line so do all of the parents.
+	const PlayerID lastPlayer = sGetPlayerToMove(markerCount - 1);
+	if (HasLine(masks[1 - lastPlayer]))
+	{
+		return 0;
+	}
+
+	uint32_t parentMasks[2] = { masks[0], masks[1] };
+	for (uint32_t cell = 0; cell < _cellCount; cell++)
+	{
+		const uint32_t cellMask = 1u << cell;
+		if ((masks[lastPlayer] & cellMask) == 0)
+		{
+			continue;
+		}
+
+		parentMasks[lastPlayer] = masks[lastPlayer] & ~cellMask;
+		if (entries[GetIndex(parentMasks)] != 0 && !HasLine(parentMasks[lastPlayer]))
+		{
+			return kReachableEntry;
+		}
+	}
+	return 0;
+}
+
+// Solves a reachable position from the (already solved) positions after each move.
+uint8_t Tablebase::Solve(uint32_t markerCount, const uint32_t (&masks)[2], const uint8_t* entries) const
+{
+	// The game is over if the last player made a line (the only player who can have one) or the board is full.
+	if (markerCount > 0 && HasLine(masks[sGetPlayerToMove(markerCount - 1)]))
+	{
+		return sMakeEntry(TablebaseValue::Loss, 0);
+	}
+	if (markerCount == _cellCount)
+	{
+		return sMakeEntry(TablebaseValue::Draw, 0);
+	}
+
+	const PlayerID playerID = sGetPlayerToMove(markerCount);
+	uint32_t childMasks[2] = { masks[0], masks[1] };
+	bool hasWin = false;
+	bool hasDraw = false;
+	uint32_t winDistance = kDistanceMask;
+	uint32_t lossDistance = 0;
+	for (uint32_t cell = 0; cell < _cellCount; cell++)
+	{
+		const uint32_t cellMask = 1u << cell;
+		if ((masks[0] | masks[1]) & cellMask)
+		{
+			continue;
+		}
+
+		childMasks[playerID] = masks[playerID] | cellMask;
+		const uint8_t childEntry = entries[GetIndex(childMasks)];
+		const uint32_t childDistance = childEntry & kDistanceMask;
+		switch (sGetValue(childEntry))
+		{
+			case TablebaseValue::Loss:
+				hasWin = true;
+				winDistance = (childDistance < winDistance) ? childDistance : winDistance;
+				break;
+
+			case TablebaseValue::Draw:
+				hasDraw = true;
+				break;
+
+			case TablebaseValue::Win:
+				lossDistance = (childDistance > lossDistance) ? childDistance : lossDistance;
+				break;
+
+			default:
+				assert(false);
+				break;
+		}
+	}
+
+	if (hasWin)
+	{
+		return sMakeEntry(TablebaseValue::Win, winDistance + 1);
+	}
+	if (hasDraw)
+	{
+		return sMakeEntry(TablebaseValue::Draw, 0);
+	}
+	return sMakeEntry(TablebaseValue::Loss, lossDistance + 1);
+}
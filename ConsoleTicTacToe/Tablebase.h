@@ -0,0 +1,119 @@
+#pragma once
+
+#include "GameBoard.h"
+#include "MappedFile.h"
+
+#include <cstdint>
+#include <vector>
+
+namespace tictactoe
+{
+	// The result of a position with perfect play, for the player to move.
+	enum class TablebaseValue : uint8_t
+	{
+		Unknown = 0,	// Not a position that can come up in a game.
+		Win,
+		Draw,
+		Loss,
+
+		Count
+	};
+
+	struct TablebaseEntry
+	{
+		TablebaseValue value;
+		uint8_t distance;	// The number of moves left until the game is won (0 for draws).
+	};
+
+	// The tablebase file format.
+	//
+	// A file is a Header followed by a byte per position: its TablebaseValue in the top 2 bits and its distance in
+	// the lower 6. Positions are numbered by a minimal perfect hash over every board where player 1 has either as
+	// many markers as player 2 or one more (see Tablebase::GetIndex()), so the file needs no keys.
+	namespace TablebaseFormat
+	{
+		static const uint8_t kMagic[4] = { 'M', 'N', 'K', 'T' };
+		static const uint16_t kVersion = 1;
+
+		static const uint8_t kValueShift = 6;
+		static const uint8_t kDistanceMask = (1 << kValueShift) - 1;
+
+		struct Header
+		{
+			uint8_t magic[4];
+			uint16_t version;
+			uint16_t columns;
+			uint16_t rows;
+			uint16_t winCondition;
+			uint32_t reserved;
+			uint64_t positionCount;
+		};
+
+		static_assert(sizeof(Header) == 24, "The tablebase header must have no padding.");
+	}
+
+	// The perfect-play value of every position of a small m,n,k board, built once by retrograde analysis (see
+	// Build()) and then memory-mapped, so that opening it doesn't read the entries and each lookup is a single
+	// hash computation over the board's cells.
+	class Tablebase
+	{
+	public:
+		// Positions are indexed by bit masks of each player's cells, so boards can have at most this many cells.
+		static const uint32_t kMaxCellCount = 16;
+
+		static bool IsSupported(uint16_t m, uint16_t n, uint16_t k);
+
+		// Solves every reachable position of a m,n,k board with a WorkStealingPool of threadCount threads, writes
+		// the tablebase to the given file, and prints a summary.
+		static bool Build(uint16_t m, uint16_t n, uint16_t k, uint16_t threadCount, const char* path);
+
+	public:
+		Tablebase();
+
+		Tablebase(const Tablebase&) = delete;
+		Tablebase& operator=(const Tablebase&) = delete;
+
+		bool Open(const char* path);
+		void Close();
+
+		bool IsOpen() const { return _entries != nullptr; }
+		uint16_t GetColumns() const { return _columns; }
+		uint16_t GetRows() const { return _rows; }
+		uint16_t GetWinCondition() const { return _winCondition; }
+		uint64_t GetPositionCount() const { return _layerOffsets[_cellCount + 1]; }
+
+		// Returns false if the board isn't the tablebase's size or the position can't come up in a game.
+		bool Probe(const GameBoard& gameBoard, TablebaseEntry* outEntry) const;
+
+		// The move with the best result for the player to move: the fastest win, any draw, or the slowest loss.
+		// Returns false if the position isn't in the tablebase or the game is over.
+		bool ChooseMove(const GameBoard& gameBoard, PlayerID playerID, BoardPosition* outPosition, TablebaseEntry* outEntry) const;
+
+	private:
+		void Initialize(uint16_t m, uint16_t n, uint16_t k);
+
+		bool TryGetMasks(const GameBoard& gameBoard, uint32_t* outMasks) const;
+		uint64_t GetIndex(const uint32_t (&masks)[2]) const;
+		bool HasLine(uint32_t mask) const;
+		TablebaseEntry GetEntry(uint64_t index) const;
+
+		template<typename Func> void ForEachPosition(uint32_t markerCount, uint64_t xRank, Func&& func) const;
+		uint8_t FindReachability(uint32_t markerCount, const uint32_t (&masks)[2], const uint8_t* entries) const;
+		uint8_t Solve(uint32_t markerCount, const uint32_t (&masks)[2], const uint8_t* entries) const;
+
+		uint16_t _columns;
+		uint16_t _rows;
+		uint16_t _winCondition;
+		uint32_t _cellCount;
+
+		// Binomial coefficients, and where the positions with each number of markers start.
+		uint32_t _binomials[kMaxCellCount + 1][kMaxCellCount + 1];
+		uint64_t _layerOffsets[kMaxCellCount + 2];
+
+		// Every winning line of the board as a mask of its cells.
+		std::vector<uint32_t> _lineMasks;
+
+		MappedFile _file;
+		const uint8_t* _entries;
+	};
+}
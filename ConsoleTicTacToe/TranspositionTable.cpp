@@ -0,0 +1,72 @@
+#include "TranspositionTable.h"
+
+#include <algorithm>
+#include <cstddef>
+
+using namespace tictactoe;
+
+TranspositionTable::TranspositionTable(uint32_t sizeInMB) :
+	_slots(),
+	_slotCount(1),
+	_indexMask(0)
+{
+	// Round down to a power of two so slots can be selected with a mask.
+	const uint64_t maxSlots = std::max<uint64_t>((static_cast<uint64_t>(sizeInMB) << 20) / sizeof(Slot), 1);
+	while ((_slotCount << 1) <= maxSlots)
+	{
+		_slotCount <<= 1;
+	}
+
+	_slots.reset(new Slot[static_cast<size_t>(_slotCount)]);
+	_indexMask = _slotCount - 1;
+	Clear();
+}
+
+bool TranspositionTable::Probe(uint64_t key, Entry* outEntry) const
+{
+	const Slot& slot = _slots[static_cast<size_t>(key & _indexMask)];
+	const uint64_t data0 = slot.data0.load(std::memory_order_relaxed);
+	const uint64_t data1 = slot.data1.load(std::memory_order_relaxed);
+	const uint64_t check = slot.check.load(std::memory_order_relaxed);
+
+	const ScoreBound bound = static_cast<ScoreBound>(data1 & 0xFF);
+	if (bound == ScoreBound::None || (check ^ data0 ^ data1) != key)
+	{
+		return false;
+	}
+
+	outEntry->key = key;
+	outEntry->score = static_cast<int32_t>(static_cast<uint32_t>(data0 >> 32));
+	outEntry->bestMove = static_cast<uint32_t>(data0);
+	outEntry->depth = static_cast<uint16_t>(data1 >> 16);
+	outEntry->bound = bound;
+	return true;
+}
+
+void TranspositionTable::Store(uint64_t key, int32_t score, uint16_t depth, ScoreBound bound, uint32_t bestMove)
+{
+	Slot& slot = _slots[static_cast<size_t>(key & _indexMask)];
+
+	// Keep a deeper result for the same position; a torn read here only affects which entry is kept.
+	Entry existing;
+	if (Probe(key, &existing) && existing.depth > depth)
+	{
+		return;
+	}
+
+	const uint64_t data0 = (static_cast<uint64_t>(static_cast<uint32_t>(score)) << 32) | bestMove;
+	const uint64_t data1 = (static_cast<uint64_t>(depth) << 16) | static_cast<uint64_t>(bound);
+	slot.data0.store(data0, std::memory_order_relaxed);
+	slot.data1.store(data1, std::memory_order_relaxed);
+	slot.check.store(key ^ data0 ^ data1, std::memory_order_relaxed);
+}
+
+void TranspositionTable::Clear()
+{
+	for (uint64_t i = 0; i < _slotCount; i++)
+	{
+		_slots[static_cast<size_t>(i)].check.store(0, std::memory_order_relaxed);
+		_slots[static_cast<size_t>(i)].data0.store(0, std::memory_order_relaxed);
+		_slots[static_cast<size_t>(i)].data1.store(0, std::memory_order_relaxed);
+	}
+}
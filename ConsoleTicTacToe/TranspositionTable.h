@@ -0,0 +1,55 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+
+namespace tictactoe
+{
+	enum class ScoreBound : uint8_t
+	{
+		None = 0,
+		Exact,
+		Lower,
+		Upper,
+
+		Count
+	};
+
+	// A fixed-size hash table of previously searched positions, keyed by GameBoard::GetHash().
+	// Each slot holds a single entry; collisions are resolved by preferring the deeper search.
+	// The table can be shared by several searching threads without locking: each slot stores its key XORed with
+	// its data words, so a slot torn by concurrent writes fails verification in Probe() and is treated as a miss.
+	class TranspositionTable
+	{
+	public:
+		static const uint32_t kNoMove = UINT32_MAX;
+
+		struct Entry
+		{
+			uint64_t key;
+			int32_t score;
+			uint32_t bestMove;
+			uint16_t depth;
+			ScoreBound bound;
+		};
+
+		explicit TranspositionTable(uint32_t sizeInMB);
+
+		bool Probe(uint64_t key, Entry* outEntry) const;
+		void Store(uint64_t key, int32_t score, uint16_t depth, ScoreBound bound, uint32_t bestMove);
+		void Clear();
+
+	private:
+		struct Slot
+		{
+			std::atomic<uint64_t> check;	// key ^ data0 ^ data1
+			std::atomic<uint64_t> data0;	// score (upper 32 bits), best move (lower 32 bits)
+			std::atomic<uint64_t> data1;	// depth (bits 16-31), bound (bits 0-7)
+		};
+
+		std::unique_ptr<Slot[]> _slots;
+		uint64_t _slotCount;
+		uint64_t _indexMask;
+	};
+}
@@ -0,0 +1,297 @@
+#pragma once
+
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <utility>
+#include <vector>
+
+namespace tictactoe
+{
+	// The default UndoTree ApplyPolicy, which forwards to ApplyFuncs set at runtime (see UndoTree::SetCallbacks()).
+	template <typename T>
+	class CallbackApplyPolicy
+	{
+	public:
+		typedef std::function<void(const T&)> ApplyFunc;
+
+		CallbackApplyPolicy() : _applyUndoFunc(nullptr), _applyRedoFunc(nullptr) {}
+
+		void SetCallbacks(ApplyFunc applyUndoFunc, ApplyFunc applyRedoFunc)
+		{
+			_applyUndoFunc = std::move(applyUndoFunc);
+			_applyRedoFunc = std::move(applyRedoFunc);
+		}
+
+		void ApplyUndo(const T& move) const { _applyUndoFunc(move); }
+		void ApplyRedo(const T& move) const { _applyRedoFunc(move); }
+
+	private:
+		ApplyFunc _applyUndoFunc;
+		ApplyFunc _applyRedoFunc;
+	};
+
+	// Maintains a history of generic objects, allowing them to be un- & re- applied with the given ApplyPolicy.
+	// Adding a move after undoing starts a new branch instead of discarding the moves that could have been redone,
+	// so every line that has been played stays in the history.
+	//
+	// An ApplyPolicy is any type with ApplyUndo(const T&) & ApplyRedo(const T&) members. Since it is a template
+	// parameter those calls can be inlined, which matters when undoing or redoing many moves at once; the default
+	// CallbackApplyPolicy trades that for being able to set the callbacks at runtime.
+	//
+	// The nodes are stored in a single array and linked by index (parent, first child & next sibling). The root node
+	// holds no move; every other node holds the move that leads to it from its parent. Redo() follows the child that
+	// was most recently visited, and JumpTo() moves to any node by un-applying the moves up to the common ancestor of
+	// the current & target nodes, then re-applying the moves down to the target.
+	template <typename T, typename ApplyPolicy = CallbackApplyPolicy<T>>
+	class UndoTree
+	{
+	public:
+		typedef std::function<void(const T&)> ApplyFunc;
+		typedef uint32_t NodeIndex;
+
+		static const NodeIndex kRootNode = 0;
+		static const NodeIndex kNoNode = UINT32_MAX;
+
+		explicit UndoTree(ApplyPolicy applyPolicy = ApplyPolicy());
+
+		// Only available with the CallbackApplyPolicy.
+		void SetCallbacks(ApplyFunc applyUndoFunc, ApplyFunc applyRedoFunc);
+
+		ApplyPolicy& GetApplyPolicy() { return _applyPolicy; }
+		const ApplyPolicy& GetApplyPolicy() const { return _applyPolicy; }
+
+		// Preallocates room for the given number of moves, so that adding that many won't reallocate.
+		void Reserve(uint64_t moveCount);
+
+		// Moves to the current node's child with the given move, adding it if there isn't one yet.
+		// The move itself is expected to already have been applied.
+		void Add(const T& move);
+		bool Undo();
+		bool Redo();
+		bool JumpTo(NodeIndex nodeIndex);
+		void Clear();
+
+		// Makes a node of the current line (any that Undo() or Redo() alone would reach) current without applying any
+		// moves, for callers that bring their state there some other way (see GameSimulation::SeekTo()).
+		void MoveTo(NodeIndex nodeIndex);
+
+		uint64_t GetAvailableUndosCount() const { return _nodes[_currentNode].depth; }
+		uint64_t GetAvailableRedosCount() const { return _redoCount; }
+
+		NodeIndex GetCurrentNode() const { return _currentNode; }
+		NodeIndex GetNodeCount() const { return static_cast<NodeIndex>(_nodes.size()); }
+
+		// Every node but the root.
+		const T& GetMove(NodeIndex nodeIndex) const { assert(nodeIndex != kRootNode); return _nodes[nodeIndex].move; }
+		NodeIndex GetParent(NodeIndex nodeIndex) const { return _nodes[nodeIndex].parent; }
+		NodeIndex GetFirstChild(NodeIndex nodeIndex) const { return _nodes[nodeIndex].firstChild; }
+		NodeIndex GetNextSibling(NodeIndex nodeIndex) const { return _nodes[nodeIndex].nextSibling; }
+		NodeIndex GetRedoChild(NodeIndex nodeIndex) const { return _nodes[nodeIndex].redoChild; }
+		uint32_t GetDepth(NodeIndex nodeIndex) const { return _nodes[nodeIndex].depth; }
+
+	private:
+		struct Node
+		{
+			T move;
+			NodeIndex parent;
+			NodeIndex firstChild;
+			NodeIndex nextSibling;
+			NodeIndex redoChild;
+			uint32_t depth;
+			uint32_t redoCount;	// Only kept up to date while the node is off the current line; see EnterChild().
+		};
+
+		NodeIndex FindChild(NodeIndex parentIndex, const T& move) const;
+		void EnterChild(NodeIndex childIndex);
+		void ClimbToParent();
+		void DescendToChild(NodeIndex childIndex);
+
+		ApplyPolicy _applyPolicy;
+
+		std::vector<Node> _nodes;
+		NodeIndex _currentNode;
+		uint64_t _redoCount;
+
+		std::vector<NodeIndex> _jumpPath;
+	};
+
+	#pragma region UndoTree<T> Implementation
+
+	template <typename T, typename ApplyPolicy>
+	UndoTree<T, ApplyPolicy>::UndoTree(ApplyPolicy applyPolicy) :
+		_applyPolicy(std::move(applyPolicy)),
+		_nodes(),
+		_currentNode(kRootNode),
+		_redoCount(0),
+		_jumpPath()
+	{
+		Clear();
+	}
+
+	template <typename T, typename ApplyPolicy>
+	void UndoTree<T, ApplyPolicy>::SetCallbacks(ApplyFunc applyUndoFunc, ApplyFunc applyRedoFunc)
+	{
+		_applyPolicy.SetCallbacks(std::move(applyUndoFunc), std::move(applyRedoFunc));
+	}
+
+	template <typename T, typename ApplyPolicy>
+	void UndoTree<T, ApplyPolicy>::Reserve(uint64_t moveCount)
+	{
+		// Caps the request where size_t (or NodeIndex) is too small to hold it; the tree still grows on demand.
+		const uint64_t maxNodeCount = (_nodes.max_size() < kNoNode) ? _nodes.max_size() : kNoNode;
+		_nodes.reserve(static_cast<size_t>((moveCount < maxNodeCount) ? (moveCount + 1) : maxNodeCount));
+	}
+
+	template <typename T, typename ApplyPolicy>
+	void UndoTree<T, ApplyPolicy>::Add(const T& move)
+	{
+		NodeIndex childIndex = FindChild(_currentNode, move);
+		if (childIndex == kNoNode)
+		{
+			assert(_nodes.size() < kNoNode);
+			childIndex = static_cast<NodeIndex>(_nodes.size());
+
+			Node& parent = _nodes[_currentNode];
+			_nodes.push_back({ move, _currentNode, kNoNode, parent.firstChild, kNoNode, parent.depth + 1, 0 });
+			_nodes[_currentNode].firstChild = childIndex;
+		}
+
+		EnterChild(childIndex);
+	}
+
+	template <typename T, typename ApplyPolicy>
+	bool UndoTree<T, ApplyPolicy>::Undo()
+	{
+		bool result = false;
+		if (_currentNode != kRootNode)
+		{
+			ClimbToParent();
+			result = true;
+		}
+		return result;
+	}
+
+	template <typename T, typename ApplyPolicy>
+	bool UndoTree<T, ApplyPolicy>::Redo()
+	{
+		bool result = false;
+		const NodeIndex childIndex = _nodes[_currentNode].redoChild;
+		if (childIndex != kNoNode)
+		{
+			DescendToChild(childIndex);
+			result = true;
+		}
+		return result;
+	}
+
+	template <typename T, typename ApplyPolicy>
+	bool UndoTree<T, ApplyPolicy>::JumpTo(NodeIndex nodeIndex)
+	{
+		if (nodeIndex >= _nodes.size())
+		{
+			return false;
+		}
+
+		// Climb from whichever node is deeper until both are at the same depth, then climb from both at once until
+		// they meet at the common ancestor, remembering the target's side of the path to walk back down.
+		NodeIndex targetAncestor = nodeIndex;
+		_jumpPath.clear();
+		while (_nodes[targetAncestor].depth > _nodes[_currentNode].depth)
+		{
+			_jumpPath.push_back(targetAncestor);
+			targetAncestor = _nodes[targetAncestor].parent;
+		}
+		while (_nodes[_currentNode].depth > _nodes[targetAncestor].depth)
+		{
+			ClimbToParent();
+		}
+		while (_currentNode != targetAncestor)
+		{
+			ClimbToParent();
+			_jumpPath.push_back(targetAncestor);
+			targetAncestor = _nodes[targetAncestor].parent;
+		}
+
+		for (auto it = _jumpPath.rbegin(); it != _jumpPath.rend(); ++it)
+		{
+			DescendToChild(*it);
+		}
+		return true;
+	}
+
+	template <typename T, typename ApplyPolicy>
+	void UndoTree<T, ApplyPolicy>::Clear()
+	{
+		_nodes.clear();
+		_nodes.push_back({ T(), kNoNode, kNoNode, kNoNode, kNoNode, 0, 0 });
+		_currentNode = kRootNode;
+		_redoCount = 0;
+	}
+
+	template <typename T, typename ApplyPolicy>
+	void UndoTree<T, ApplyPolicy>::MoveTo(NodeIndex nodeIndex)
+	{
+		assert(nodeIndex < _nodes.size());
+
+		// The redo children along the current line already lead through both nodes, so only the count changes.
+		_redoCount = (_redoCount + _nodes[_currentNode].depth) - _nodes[nodeIndex].depth;
+		_currentNode = nodeIndex;
+	}
+
+	template <typename T, typename ApplyPolicy>
+	typename UndoTree<T, ApplyPolicy>::NodeIndex UndoTree<T, ApplyPolicy>::FindChild(NodeIndex parentIndex, const T& move) const
+	{
+		for (NodeIndex childIndex = _nodes[parentIndex].firstChild; childIndex != kNoNode; childIndex = _nodes[childIndex].nextSibling)
+		{
+			if (_nodes[childIndex].move == move)
+			{
+				return childIndex;
+			}
+		}
+		return kNoNode;
+	}
+
+	template <typename T, typename ApplyPolicy>
+	void UndoTree<T, ApplyPolicy>::EnterChild(NodeIndex childIndex)
+	{
+		Node& parent = _nodes[_currentNode];
+		assert(_nodes[childIndex].parent == _currentNode);
+
+		// Nodes below the current line are only changed while they're on it, so a node that leaves the line keeps
+		// the redo count it had, ready for when it's entered again.
+		if (childIndex == parent.redoChild)
+		{
+			_redoCount--;
+		}
+		else
+		{
+			if (parent.redoChild != kNoNode)
+			{
+				_nodes[parent.redoChild].redoCount = static_cast<uint32_t>(_redoCount - 1);
+			}
+			parent.redoChild = childIndex;
+			_redoCount = _nodes[childIndex].redoCount;
+		}
+		_currentNode = childIndex;
+	}
+
+	template <typename T, typename ApplyPolicy>
+	void UndoTree<T, ApplyPolicy>::ClimbToParent()
+	{
+		const Node& node = _nodes[_currentNode];
+		_currentNode = node.parent;
+		_redoCount++;
+		_applyPolicy.ApplyUndo(node.move);
+	}
+
+	template <typename T, typename ApplyPolicy>
+	void UndoTree<T, ApplyPolicy>::DescendToChild(NodeIndex childIndex)
+	{
+		EnterChild(childIndex);
+		_applyPolicy.ApplyRedo(_nodes[childIndex].move);
+	}
+
+	#pragma endregion
+}
@@ -0,0 +1,89 @@
+#include "WorkStealingPool.h"
+
+#include <cassert>
+#include <thread>
+#include <vector>
+
+using namespace tictactoe;
+
+WorkStealingPool::WorkStealingPool(uint16_t threadCount) :
+	_threadCount(threadCount),
+	_taskRanges(new TaskRange[threadCount])
+{
+	assert(threadCount > 0);
+}
+
+WorkStealingPool::~WorkStealingPool()
+{
+}
+
+void WorkStealingPool::Run(uint64_t taskCount, const TaskFunc& runTask)
+{
+	for (uint16_t i = 0; i < _threadCount; i++)
+	{
+		_taskRanges[i].begin = (taskCount * i) / _threadCount;
+		_taskRanges[i].end = (taskCount * (i + 1)) / _threadCount;
+	}
+
+	std::vector<std::thread> threads;
+	for (uint16_t i = 1; i < _threadCount; i++)
+	{
+		threads.emplace_back(&WorkStealingPool::RunWorker, this, i, std::cref(runTask));
+	}
+	RunWorker(0, runTask);
+
+	for (std::thread& thread : threads)
+	{
+		thread.join();
+	}
+}
+
+void WorkStealingPool::RunWorker(uint16_t workerIndex, const TaskFunc& runTask)
+{
+	uint64_t taskIndex;
+	while (TryTakeTask(workerIndex, &taskIndex) || (TryStealTasks(workerIndex) && TryTakeTask(workerIndex, &taskIndex)))
+	{
+		runTask(workerIndex, taskIndex);
+	}
+}
+
+bool WorkStealingPool::TryTakeTask(uint16_t workerIndex, uint64_t* outTaskIndex)
+{
+	TaskRange& taskRange = _taskRanges[workerIndex];
+	std::lock_guard<std::mutex> lock(taskRange.mutex);
+	if (taskRange.begin == taskRange.end)
+	{
+		return false;
+	}
+	*outTaskIndex = taskRange.begin++;
+	return true;
+}
+
+bool WorkStealingPool::TryStealTasks(uint16_t workerIndex)
+{
+	// Once every other worker's share is empty, the only tasks left are already being run.
+	for (uint16_t i = 1; i < _threadCount; i++)
+	{
+		TaskRange& victimRange = _taskRanges[(workerIndex + i) % _threadCount];
+
+		uint64_t stolenBegin;
+		uint64_t stolenEnd;
+		{
+			std::lock_guard<std::mutex> lock(victimRange.mutex);
+			if (victimRange.begin == victimRange.end)
+			{
+				continue;
+			}
+			stolenBegin = victimRange.begin + ((victimRange.end - victimRange.begin) / 2);
+			stolenEnd = victimRange.end;
+			victimRange.end = stolenBegin;
+		}
+
+		TaskRange& taskRange = _taskRanges[workerIndex];
+		std::lock_guard<std::mutex> lock(taskRange.mutex);
+		taskRange.begin = stolenBegin;
+		taskRange.end = stolenEnd;
+		return true;
+	}
+	return false;
+}
@@ -0,0 +1,42 @@
+#pragma once
+
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+
+namespace tictactoe
+{
+	// Runs a batch of independent tasks, numbered 0 to taskCount - 1, on a fixed number of threads.
+	// Each worker starts with an even share of the tasks and takes them one at a time from the front of its share;
+	// a worker that runs out steals the back half of another worker's remaining share. Tasks that vary in length
+	// (like games) therefore still keep every thread busy until the whole batch is done.
+	class WorkStealingPool
+	{
+	public:
+		typedef std::function<void(uint16_t workerIndex, uint64_t taskIndex)> TaskFunc;
+
+		explicit WorkStealingPool(uint16_t threadCount);
+		~WorkStealingPool();
+
+		uint16_t GetThreadCount() const { return _threadCount; }
+
+		// Blocks until every task has run; the calling thread works as worker 0.
+		void Run(uint64_t taskCount, const TaskFunc& runTask);
+
+	private:
+		struct TaskRange
+		{
+			std::mutex mutex;
+			uint64_t begin;
+			uint64_t end;
+		};
+
+		void RunWorker(uint16_t workerIndex, const TaskFunc& runTask);
+		bool TryTakeTask(uint16_t workerIndex, uint64_t* outTaskIndex);
+		bool TryStealTasks(uint16_t workerIndex);
+
+		uint16_t _threadCount;
+		std::unique_ptr<TaskRange[]> _taskRanges;
+	};
+}
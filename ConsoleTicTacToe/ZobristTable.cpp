@@ -0,0 +1,34 @@
+#include "ZobristTable.h"
+
+#include <cstddef>
+
+using namespace tictactoe;
+
+static const uint64_t kZobristSeed = 0x9E3779B97F4A7C15ull;
+
+static uint64_t sSplitMix64(uint64_t& state);
+
+ZobristTable::ZobristTable(uint16_t columns, uint16_t rows, uint16_t numPlayers) :
+	_numPlayers(numPlayers),
+	_keys()
+{
+	uint64_t state = kZobristSeed ^
+		(static_cast<uint64_t>(columns) << 32) ^
+		(static_cast<uint64_t>(rows) << 16) ^
+		static_cast<uint64_t>(numPlayers);
+
+	_keys.resize(static_cast<size_t>(columns) * rows * numPlayers);
+	for (auto& key : _keys)
+	{
+		key = sSplitMix64(state);
+	}
+}
+
+// Reference: http://xoshiro.di.unimi.it/splitmix64.c
+static uint64_t sSplitMix64(uint64_t& state)
+{
+	uint64_t z = (state += 0x9E3779B97F4A7C15ull);
+	z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+	z = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+	return z ^ (z >> 31);
+}
@@ -0,0 +1,23 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+namespace tictactoe
+{
+	// A table of random 64-bit keys, one per (cell, player) pair, used to incrementally hash board positions.
+	// See https://en.wikipedia.org/wiki/Zobrist_hashing
+	// Keys are generated from a fixed seed mixed with the board dimensions and player count,
+	// so the same configuration always produces the same table (and the same position hashes).
+	class ZobristTable
+	{
+	public:
+		ZobristTable(uint16_t columns, uint16_t rows, uint16_t numPlayers);
+
+		uint64_t GetKey(uint32_t cellIndex, uint16_t playerID) const { return _keys[(cellIndex * _numPlayers) + playerID]; }
+
+	private:
+		uint16_t _numPlayers;
+		std::vector<uint64_t> _keys;
+	};
+}
@@ -1,89 +1,511 @@
+#include "AlphaBetaPlayer.h"
 #include "BasicGame.h"
+#include "Benchmark.h"
+#include "ConsoleInterface.h"
 #include "FancyGame.h"
+#include "GameAnalysis.h"
+#include "GameRecord.h"
+#include "GreedyPlayer.h"
+#include "MappedFile.h"
+#include "MCTSPlayer.h"
+#include "MoveJournal.h"
+#include "OpeningBook.h"
+#include "RandomPlayer.h"
+#include "SelfPlay.h"
+#include "Tablebase.h"
 
+#include <csignal>
+#include <cstring>
+#include <fstream>
 #include <iomanip>
 #include <iostream>
+#include <memory>
 #include <string>
 
+#ifndef _WIN32
+#include <termios.h>
+#include <unistd.h>
+#endif
+
+static const uint16_t kDefaultAIMoveTimeMs = 1000;
+static const uint32_t kAITranspositionTableSizeMB = 64;
+static const uint32_t kAINodePoolSizeMB = 256;
+
+// Self-play runs a pair of players per thread, so each engine player gets less memory.
+static const uint32_t kSelfPlayTranspositionTableSizeMB = 16;
+static const uint32_t kSelfPlayNodePoolSizeMB = 32;
+
+// An opening book covers the first moves of each game, and only the positions that enough games went through.
+static const uint32_t kOpeningBookPlyCount = 12;
+static const uint32_t kOpeningBookMinGameCount = 4;
+
+enum class AIEngine
+{
+	AlphaBeta = 0,
+	MCTS,
+
+	Count
+};
+
+enum class SelfPlayPolicy
+{
+	Random = 0,
+	Greedy,
+	Engine,
+
+	Count
+};
+
+struct GameOptions
+{
+	uint16_t m;
+	uint16_t n;
+	uint16_t k;
+	bool isFancy;
+	bool isAIPlayer[tictactoe::GameSimulation::kNumPlayers];
+	uint16_t aiMoveTimeMs;
+	uint16_t aiThreadCount;
+	AIEngine aiEngine;
+	uint32_t aiPlayoutLimit;
+	bool isBenchmark;
+	uint32_t selfPlayGameCount;
+	SelfPlayPolicy selfPlayPolicies[tictactoe::GameSimulation::kNumPlayers];
+	uint16_t selfPlayPolicyCount;
+	const char* recordPath;
+	const char* exportPath;
+	const char* journalPath;
+	const char* resumePath;
+	const char* analyzePath;
+	tictactoe::AnalysisFormat analysisFormat;
+	bool hasAnalysisFormat;
+	const char* tablebasePath;
+	const char* buildTablebasePath;
+	const char* openingBookPath;
+	const char* buildOpeningBookPath;
+	const char* openingBookRecordPath;
+};
+
 static tictactoe::GameSimulation* sgGame = nullptr;
-static void sCreateGameSimulation(uint16_t m, uint16_t n, uint16_t k, bool isFancy);
+static bool sCreateGameSimulation(const GameOptions& options);
 static void sDestroyGameSimulation();
 
+static tictactoe::MoveJournal* sgMoveJournal = nullptr;
+static bool sOpenMoveJournal(const GameOptions& options);
+static void sCloseGameOutputs();
+
+static std::ofstream sgRecordStream;
+static tictactoe::GameRecordWriter* sgRecordWriter = nullptr;
+static bool sOpenRecordStream(const GameOptions& options);
+static bool sExportGameRecords(const char* path);
+
+static tictactoe::Tablebase sgTablebase;
+static bool sOpenTablebase(const GameOptions& options);
+
+static tictactoe::OpeningBook sgOpeningBook;
+static bool sOpenOpeningBook(const GameOptions& options);
+
+static void sSetInterruptHandler(bool isEnabled);
+#ifdef _WIN32
 static BOOL WINAPI sConsoleCtrlHandler(DWORD dwCtrlType);
+#else
+static volatile sig_atomic_t sgInterruptSignal = 0;
+static termios sgInitialTermios;
+static bool sgHasInitialTermios = false;
+static void sInterruptSignalHandler(int signal);
+#endif
 
+static bool sTryParseOptions(int argc, char** argv, GameOptions* outOptions);
 static bool sTryParseUInt(const std::string& str, uint16_t minValue, uint16_t* outValue);
+static bool sTryParseUInt(const std::string& str, uint32_t minValue, uint32_t maxValue, uint32_t* outValue);
+static std::unique_ptr<tictactoe::AIPlayer> sCreateAIPlayer(const GameOptions& options);
+static std::unique_ptr<tictactoe::AIPlayer> sCreateSelfPlayPlayer(const GameOptions& options, SelfPlayPolicy policy, uint64_t seed);
+static void sRunSelfPlay(const GameOptions& options);
 static void sPrintUsage();
 
 int main(int argc, char** argv)
 {
-	if (argc < 4 || argc > 5)
+	GameOptions options;
+	if (!sTryParseOptions(argc, argv, &options))
 	{
 		sPrintUsage();
 		return EXIT_FAILURE;
 	}
 
-	// Parse the first 3 parameters (m, n, k).
-	uint16_t m;
-	uint16_t n;
-	uint16_t k;
-	if (!sTryParseUInt(argv[1], 3, &m) ||
-		!sTryParseUInt(argv[2], 3, &n) ||
-		!sTryParseUInt(argv[3], 3, &k))
+	if (options.exportPath != nullptr)
+	{
+		return sExportGameRecords(options.exportPath) ? EXIT_SUCCESS : EXIT_FAILURE;
+	}
+
+	if (options.buildTablebasePath != nullptr)
+	{
+		if (!tictactoe::Tablebase::Build(options.m, options.n, options.k, options.aiThreadCount, options.buildTablebasePath))
+		{
+			std::cerr << "Error: Unable to write the tablebase to '" << options.buildTablebasePath << "'." << std::endl;
+			return EXIT_FAILURE;
+		}
+		return EXIT_SUCCESS;
+	}
+
+	if (options.buildOpeningBookPath != nullptr)
+	{
+		const bool result = tictactoe::OpeningBook::Build(
+			options.openingBookRecordPath, options.m, options.n, options.k, kOpeningBookPlyCount, kOpeningBookMinGameCount,
+			options.buildOpeningBookPath);
+		return result ? EXIT_SUCCESS : EXIT_FAILURE;
+	}
+
+	// A resumed game takes its board size from the journal.
+	if (options.resumePath != nullptr &&
+		!tictactoe::MoveJournal::ReadBoardSize(options.resumePath, &options.m, &options.n, &options.k))
+	{
+		std::cerr << "Error: '" << options.resumePath << "' is not a move journal." << std::endl;
+		return EXIT_FAILURE;
+	}
+
+	if (!sOpenTablebase(options) || !sOpenOpeningBook(options))
 	{
-		sPrintUsage();
 		return EXIT_FAILURE;
 	}
 
-	// Parse the -fancy parameter, if given.
-	bool isFancy = false;
-	if (argc == 5)
+	if (options.analyzePath != nullptr)
 	{
-		if (strcmp(argv[4], "-fancy") == 0)
+		if (!tictactoe::RunGameAnalysis(
+			options.analyzePath, options.analysisFormat, options.aiThreadCount, options.aiMoveTimeMs,
+			sgTablebase.IsOpen() ? &sgTablebase : nullptr, std::cout))
 		{
-			isFancy = true;
+			std::cerr << "Error: Unable to read the directory '" << options.analyzePath << "'." << std::endl;
+			return EXIT_FAILURE;
+		}
+		return EXIT_SUCCESS;
+	}
+
+	if (!sOpenRecordStream(options))
+	{
+		return EXIT_FAILURE;
+	}
+
+	if (options.isBenchmark)
+	{
+		if (options.aiEngine == AIEngine::MCTS)
+		{
+			tictactoe::RunPlayoutBenchmark(options.m, options.n, options.k, options.aiThreadCount, options.aiMoveTimeMs);
 		}
 		else
 		{
-			sPrintUsage();
-			return EXIT_FAILURE;
+			tictactoe::RunSearchBenchmark(options.m, options.n, options.k, options.aiThreadCount, options.aiMoveTimeMs);
 		}
+		return EXIT_SUCCESS;
+	}
+
+	if (options.selfPlayGameCount > 0)
+	{
+		sRunSelfPlay(options);
+		return EXIT_SUCCESS;
 	}
 
 	// Create and run the game simulation.
-	sCreateGameSimulation(m, n, k, isFancy);
+	if (!sCreateGameSimulation(options))
+	{
+		sDestroyGameSimulation();
+		sCloseGameOutputs();
+		return EXIT_FAILURE;
+	}
 	while (sgGame != nullptr)
 	{
+#ifndef _WIN32
+		if (sgInterruptSignal != 0)
+		{
+			break;
+		}
+#endif
 		if (!sgGame->Update())
 		{
 			break;
 		}
 	}
 	sDestroyGameSimulation();
+	sCloseGameOutputs();
+
+#ifndef _WIN32
+	// Now that everything has been cleaned up, let the default action (termination) happen.
+	if (sgInterruptSignal != 0)
+	{
+		std::raise(sgInterruptSignal);
+	}
+#endif
 
 	return EXIT_SUCCESS;
 }
 
-static void sCreateGameSimulation(uint16_t m, uint16_t n, uint16_t k, bool isFancy)
+static bool sCreateGameSimulation(const GameOptions& options)
 {
 	if (sgGame == nullptr)
 	{
-		SetConsoleCtrlHandler(sConsoleCtrlHandler, TRUE);
-		sgGame = isFancy ?
-			static_cast<tictactoe::GameSimulation*>(new tictactoe::FancyGame(m, n, k)) :
-			static_cast<tictactoe::GameSimulation*>(new tictactoe::BasicGame(m, n, k));
+		sSetInterruptHandler(true);
+		sgGame = options.isFancy ?
+			static_cast<tictactoe::GameSimulation*>(new tictactoe::FancyGame(options.m, options.n, options.k)) :
+			static_cast<tictactoe::GameSimulation*>(new tictactoe::BasicGame(options.m, options.n, options.k));
+
+		for (tictactoe::PlayerID playerID = 0; playerID < tictactoe::GameSimulation::kNumPlayers; playerID++)
+		{
+			if (options.isAIPlayer[playerID])
+			{
+				sgGame->SetAIPlayer(playerID, sCreateAIPlayer(options));
+			}
+		}
+
+		if (!sOpenMoveJournal(options))
+		{
+			return false;
+		}
+
+		if (sgRecordStream.is_open())
+		{
+			sgRecordWriter = new tictactoe::GameRecordWriter(sgRecordStream);
+			sgGame->AddEventListener(sgRecordWriter);
+		}
+	}
+	return true;
+}
+
+static bool sOpenMoveJournal(const GameOptions& options)
+{
+	// The journal is replayed before anything listens to the game, so that it isn't journaled a second time.
+	if (options.resumePath != nullptr && !tictactoe::MoveJournal::Replay(options.resumePath, sgGame))
+	{
+		std::cerr << "Error: Unable to replay the move journal '" << options.resumePath << "'." << std::endl;
+		return false;
+	}
+
+	// A resumed game carries on journaling to the same file.
+	const char* journalPath = (options.resumePath != nullptr) ? options.resumePath : options.journalPath;
+	if (journalPath != nullptr)
+	{
+		sgMoveJournal = new tictactoe::MoveJournal();
+		if (!sgMoveJournal->Open(journalPath, options.m, options.n, options.k))
+		{
+			std::cerr << "Error: Unable to open the move journal '" << journalPath << "'." << std::endl;
+			return false;
+		}
+		sgMoveJournal->Attach(sgGame, options.resumePath != nullptr);
+	}
+	return true;
+}
+
+static std::unique_ptr<tictactoe::AIPlayer> sCreateAIPlayer(const GameOptions& options)
+{
+	std::unique_ptr<tictactoe::AIPlayer> player;
+	switch (options.aiEngine)
+	{
+		case AIEngine::MCTS:
+			// A playout limit replaces the time limit, so that each move does a fixed amount of work.
+			player = std::make_unique<tictactoe::MCTSPlayer>(
+				options.aiPlayoutLimit,
+				(options.aiPlayoutLimit > 0) ? 0 : options.aiMoveTimeMs,
+				kAINodePoolSizeMB,
+				options.aiThreadCount);
+			break;
+
+		default:
+		{
+			auto alphaBetaPlayer = std::make_unique<tictactoe::AlphaBetaPlayer>(
+				options.aiMoveTimeMs,
+				kAITranspositionTableSizeMB,
+				options.aiThreadCount);
+			alphaBetaPlayer->SetTablebase(sgTablebase.IsOpen() ? &sgTablebase : nullptr);
+			player = std::move(alphaBetaPlayer);
+			break;
+		}
 	}
+
+	player->SetOpeningBook(sgOpeningBook.IsOpen() ? &sgOpeningBook : nullptr);
+	return player;
+}
+
+static std::unique_ptr<tictactoe::AIPlayer> sCreateSelfPlayPlayer(const GameOptions& options, SelfPlayPolicy policy, uint64_t seed)
+{
+	switch (policy)
+	{
+		case SelfPlayPolicy::Random:
+			return std::make_unique<tictactoe::RandomPlayer>(seed);
+
+		case SelfPlayPolicy::Greedy:
+			return std::make_unique<tictactoe::GreedyPlayer>(seed);
+
+		default:
+		{
+			// Games are already played in parallel, so each engine searches on a single thread. Only the engine
+			// plays from the opening book; the other policies are baselines.
+			std::unique_ptr<tictactoe::AIPlayer> player;
+			if (options.aiEngine == AIEngine::MCTS)
+			{
+				player = std::make_unique<tictactoe::MCTSPlayer>(
+					options.aiPlayoutLimit,
+					(options.aiPlayoutLimit > 0) ? 0 : options.aiMoveTimeMs,
+					kSelfPlayNodePoolSizeMB,
+					1);
+			}
+			else
+			{
+				auto alphaBetaPlayer = std::make_unique<tictactoe::AlphaBetaPlayer>(options.aiMoveTimeMs, kSelfPlayTranspositionTableSizeMB, 1);
+				alphaBetaPlayer->SetTablebase(sgTablebase.IsOpen() ? &sgTablebase : nullptr);
+				player = std::move(alphaBetaPlayer);
+			}
+
+			player->SetOpeningBook(sgOpeningBook.IsOpen() ? &sgOpeningBook : nullptr);
+			return player;
+		}
+	}
+}
+
+static void sRunSelfPlay(const GameOptions& options)
+{
+	static const char* kPolicyNames[] = { "random", "greedy", "engine" };
+	static_assert(sizeof(kPolicyNames) / sizeof(kPolicyNames[0]) == static_cast<size_t>(SelfPlayPolicy::Count), "kPolicyNames needs updating.");
+
+	// A single -policy applies to both players.
+	tictactoe::SelfPlayPlayer players[tictactoe::GameSimulation::kNumPlayers];
+	for (tictactoe::PlayerID playerID = 0; playerID < tictactoe::GameSimulation::kNumPlayers; playerID++)
+	{
+		const SelfPlayPolicy policy = (playerID < options.selfPlayPolicyCount) ?
+			options.selfPlayPolicies[playerID] :
+			options.selfPlayPolicies[0];
+
+		players[playerID].name = kPolicyNames[static_cast<size_t>(policy)];
+		players[playerID].createPlayer = [&options, policy](uint64_t seed)
+		{
+			return sCreateSelfPlayPlayer(options, policy, seed);
+		};
+	}
+
+	tictactoe::RunSelfPlay(
+		options.m, options.n, options.k, options.selfPlayGameCount, options.aiThreadCount, players,
+		sgRecordStream.is_open() ? &sgRecordStream : nullptr);
 }
 
 static void sDestroyGameSimulation()
 {
 	if (sgGame != nullptr)
 	{
-		SetConsoleCtrlHandler(sConsoleCtrlHandler, FALSE);
+		sSetInterruptHandler(false);
 		delete sgGame;
 		sgGame = nullptr;
 	}
 }
 
+static void sCloseGameOutputs()
+{
+	// Destroying the writer writes out the record of the game in progress, and closing the journal writes
+	// out & syncs whatever hasn't been yet. This only happens on the way out of main, as it takes locks and
+	// waits on the disk; if the game is killed instead, the journal's recovery covers what's lost.
+	delete sgRecordWriter;
+	sgRecordWriter = nullptr;
+	delete sgMoveJournal;
+	sgMoveJournal = nullptr;
+}
+
+static bool sOpenRecordStream(const GameOptions& options)
+{
+	if (options.recordPath != nullptr && !tictactoe::GameRecordWriter::OpenFile(options.recordPath, &sgRecordStream))
+	{
+		std::cerr << "Error: Unable to open '" << options.recordPath << "' to record games to." << std::endl;
+		return false;
+	}
+	return true;
+}
+
+static bool sExportGameRecords(const char* path)
+{
+	tictactoe::MappedFile file;
+	if (!file.Open(path))
+	{
+		std::cerr << "Error: Unable to open '" << path << "'." << std::endl;
+		return false;
+	}
+
+	tictactoe::GameRecordReader reader(file.GetData(), file.GetSize());
+	if (!reader.IsValid())
+	{
+		std::cerr << "Error: '" << path << "' is not a game record file." << std::endl;
+		return false;
+	}
+
+	tictactoe::GameRecord record;
+	uint64_t gameNumber = 1;
+	while (reader.ReadNext(&record))
+	{
+		tictactoe::WriteGameRecordText(std::cout, record, gameNumber++);
+	}
+	return true;
+}
+
+static bool sOpenTablebase(const GameOptions& options)
+{
+	if (options.tablebasePath == nullptr)
+	{
+		return true;
+	}
+
+	if (!sgTablebase.Open(options.tablebasePath))
+	{
+		std::cerr << "Error: '" << options.tablebasePath << "' is not a tablebase." << std::endl;
+		return false;
+	}
+
+	// Analysis covers games of any size, and just searches the ones the tablebase isn't for.
+	if (options.analyzePath == nullptr &&
+		(sgTablebase.GetColumns() != options.m || sgTablebase.GetRows() != options.n || sgTablebase.GetWinCondition() != options.k))
+	{
+		std::cerr << "Error: The tablebase '" << options.tablebasePath << "' is for a different board size." << std::endl;
+		return false;
+	}
+	return true;
+}
+
+static bool sOpenOpeningBook(const GameOptions& options)
+{
+	if (options.openingBookPath == nullptr)
+	{
+		return true;
+	}
+
+	if (!sgOpeningBook.Open(options.openingBookPath))
+	{
+		std::cerr << "Error: '" << options.openingBookPath << "' is not an opening book." << std::endl;
+		return false;
+	}
+
+	if (sgOpeningBook.GetColumns() != options.m || sgOpeningBook.GetRows() != options.n || sgOpeningBook.GetWinCondition() != options.k)
+	{
+		std::cerr << "Error: The opening book '" << options.openingBookPath << "' is for a different board size." << std::endl;
+		return false;
+	}
+	return true;
+}
+
+static void sSetInterruptHandler(bool isEnabled)
+{
+#ifdef _WIN32
+	SetConsoleCtrlHandler(sConsoleCtrlHandler, isEnabled ? TRUE : FALSE);
+#else
+	// The terminal state is cached before the game changes it, so that the handler can restore it.
+	if (isEnabled)
+	{
+		sgHasInitialTermios = (tcgetattr(STDIN_FILENO, &sgInitialTermios) == 0);
+	}
+
+	// Without SA_RESTART, a blocking read is interrupted and the game gets to see that it should stop.
+	struct sigaction action = {};
+	action.sa_handler = isEnabled ? sInterruptSignalHandler : SIG_DFL;
+	sigemptyset(&action.sa_mask);
+	for (int signal : { SIGINT, SIGTERM, SIGHUP })
+	{
+		sigaction(signal, &action, nullptr);
+	}
+#endif
+}
+
+#ifdef _WIN32
 static BOOL WINAPI sConsoleCtrlHandler(DWORD dwCtrlType)
 {
 	// This ensures everything is cleaned up regardless of how the game is closed.
@@ -91,8 +513,353 @@ static BOOL WINAPI sConsoleCtrlHandler(DWORD dwCtrlType)
 	sDestroyGameSimulation();
 	return false;
 }
+#else
+static void sInterruptSignalHandler(int signal)
+{
+	// Only async-signal-safe calls can be made here, so the main loop is left to stop the game and clean up.
+	// If it's already been asked to and hasn't (e.g. the AI is still thinking), restore the terminal and
+	// terminate right away; the move journal covers whatever hasn't been written out.
+	if (sgInterruptSignal == 0)
+	{
+		sgInterruptSignal = signal;
+		return;
+	}
+
+	tictactoe::ConsoleInterface::WriteLeaveSequence();
+	if (sgHasInitialTermios)
+	{
+		tcsetattr(STDIN_FILENO, TCSANOW, &sgInitialTermios);
+	}
+	std::signal(signal, SIG_DFL);
+	std::raise(signal);
+}
+#endif
+
+static bool sTryParseOptions(int argc, char** argv, GameOptions* outOptions)
+{
+	*outOptions = {};
+	outOptions->aiMoveTimeMs = kDefaultAIMoveTimeMs;
+	outOptions->aiThreadCount = 1;
+
+	// Exporting records doesn't play any games, so it takes the place of the other parameters.
+	if (argc == 3 && strcmp(argv[1], "-export") == 0)
+	{
+		outOptions->exportPath = argv[2];
+		return true;
+	}
+
+	// Parse the first 3 parameters (m, n, k), which a resumed game reads from its journal instead, and which
+	// analysis reads from each recorded game.
+	int firstOptionIndex = 4;
+	if (argc >= 3 && strcmp(argv[1], "-resume") == 0)
+	{
+		outOptions->resumePath = argv[2];
+		firstOptionIndex = 3;
+	}
+	else if (argc >= 3 && strcmp(argv[1], "-analyze") == 0)
+	{
+		outOptions->analyzePath = argv[2];
+		firstOptionIndex = 3;
+	}
+	else if (argc < 4 ||
+		!sTryParseUInt(argv[1], 3, &outOptions->m) ||
+		!sTryParseUInt(argv[2], 3, &outOptions->n) ||
+		!sTryParseUInt(argv[3], 3, &outOptions->k))
+	{
+		return false;
+	}
+
+	// Parse the optional parameters, if given.
+	for (int i = firstOptionIndex; i < argc; i++)
+	{
+		const bool hasValue = (i + 1 < argc);
+		uint16_t value;
+
+		if (strcmp(argv[i], "-fancy") == 0)
+		{
+			outOptions->isFancy = true;
+		}
+		else if (strcmp(argv[i], "-ai") == 0)
+		{
+			if (!hasValue ||
+				!sTryParseUInt(argv[++i], 1, &value) ||
+				value > tictactoe::GameSimulation::kNumPlayers)
+			{
+				return false;
+			}
+			outOptions->isAIPlayer[value - 1] = true;
+		}
+		else if (strcmp(argv[i], "-time") == 0)
+		{
+			if (!hasValue ||
+				!sTryParseUInt(argv[++i], 0, &value))
+			{
+				return false;
+			}
+			outOptions->aiMoveTimeMs = value;
+		}
+		else if (strcmp(argv[i], "-threads") == 0)
+		{
+			if (!hasValue ||
+				!sTryParseUInt(argv[++i], 1, &value))
+			{
+				return false;
+			}
+			outOptions->aiThreadCount = value;
+		}
+		else if (strcmp(argv[i], "-engine") == 0)
+		{
+			if (!hasValue)
+			{
+				return false;
+			}
+
+			i++;
+			if (strcmp(argv[i], "alphabeta") == 0)
+			{
+				outOptions->aiEngine = AIEngine::AlphaBeta;
+			}
+			else if (strcmp(argv[i], "mcts") == 0)
+			{
+				outOptions->aiEngine = AIEngine::MCTS;
+			}
+			else
+			{
+				return false;
+			}
+		}
+		else if (strcmp(argv[i], "-playouts") == 0)
+		{
+			if (!hasValue ||
+				!sTryParseUInt(argv[++i], 1, UINT32_MAX, &outOptions->aiPlayoutLimit))
+			{
+				return false;
+			}
+		}
+		else if (strcmp(argv[i], "-bench") == 0)
+		{
+			outOptions->isBenchmark = true;
+		}
+		else if (strcmp(argv[i], "-record") == 0)
+		{
+			if (!hasValue)
+			{
+				return false;
+			}
+			outOptions->recordPath = argv[++i];
+		}
+		else if (strcmp(argv[i], "-format") == 0)
+		{
+			if (!hasValue)
+			{
+				return false;
+			}
+
+			i++;
+			if (strcmp(argv[i], "csv") == 0)
+			{
+				outOptions->analysisFormat = tictactoe::AnalysisFormat::Csv;
+			}
+			else if (strcmp(argv[i], "json") == 0)
+			{
+				outOptions->analysisFormat = tictactoe::AnalysisFormat::Json;
+			}
+			else
+			{
+				return false;
+			}
+			outOptions->hasAnalysisFormat = true;
+		}
+		else if (strcmp(argv[i], "-tablebase") == 0)
+		{
+			if (!hasValue)
+			{
+				return false;
+			}
+			outOptions->tablebasePath = argv[++i];
+		}
+		else if (strcmp(argv[i], "-buildtb") == 0)
+		{
+			if (!hasValue)
+			{
+				return false;
+			}
+			outOptions->buildTablebasePath = argv[++i];
+		}
+		else if (strcmp(argv[i], "-book") == 0)
+		{
+			if (!hasValue)
+			{
+				return false;
+			}
+			outOptions->openingBookPath = argv[++i];
+		}
+		else if (strcmp(argv[i], "-buildbook") == 0)
+		{
+			if (!hasValue)
+			{
+				return false;
+			}
+			outOptions->buildOpeningBookPath = argv[++i];
+		}
+		else if (strcmp(argv[i], "-from") == 0)
+		{
+			if (!hasValue)
+			{
+				return false;
+			}
+			outOptions->openingBookRecordPath = argv[++i];
+		}
+		else if (strcmp(argv[i], "-journal") == 0)
+		{
+			if (!hasValue)
+			{
+				return false;
+			}
+			outOptions->journalPath = argv[++i];
+		}
+		else if (strcmp(argv[i], "-selfplay") == 0)
+		{
+			if (!hasValue ||
+				!sTryParseUInt(argv[++i], 1, UINT32_MAX, &outOptions->selfPlayGameCount))
+			{
+				return false;
+			}
+		}
+		else if (strcmp(argv[i], "-policy") == 0)
+		{
+			if (!hasValue ||
+				outOptions->selfPlayPolicyCount == tictactoe::GameSimulation::kNumPlayers)
+			{
+				return false;
+			}
+
+			i++;
+			SelfPlayPolicy& policy = outOptions->selfPlayPolicies[outOptions->selfPlayPolicyCount++];
+			if (strcmp(argv[i], "random") == 0)
+			{
+				policy = SelfPlayPolicy::Random;
+			}
+			else if (strcmp(argv[i], "greedy") == 0)
+			{
+				policy = SelfPlayPolicy::Greedy;
+			}
+			else if (strcmp(argv[i], "engine") == 0)
+			{
+				policy = SelfPlayPolicy::Engine;
+			}
+			else
+			{
+				return false;
+			}
+		}
+		else
+		{
+			return false;
+		}
+	}
+
+	// Playouts only make sense for MCTS, and a benchmark always runs for a fixed time per move.
+	if (outOptions->aiPlayoutLimit > 0 && (outOptions->aiEngine != AIEngine::MCTS || outOptions->isBenchmark))
+	{
+		return false;
+	}
+
+	// Self-play is its own mode, with every player computer-controlled; -policy only applies to it.
+	if (outOptions->selfPlayGameCount > 0 && (outOptions->isFancy || outOptions->isBenchmark ||
+		outOptions->isAIPlayer[0] || outOptions->isAIPlayer[1]))
+	{
+		return false;
+	}
+	if (outOptions->selfPlayPolicyCount > 0 && outOptions->selfPlayGameCount == 0)
+	{
+		return false;
+	}
+
+	// A benchmark only searches positions, so there are no games to record.
+	if (outOptions->recordPath != nullptr && outOptions->isBenchmark)
+	{
+		return false;
+	}
+
+	// Only an interactive game is journaled, and a resumed one always journals to the file it was resumed from.
+	if ((outOptions->journalPath != nullptr || outOptions->resumePath != nullptr) &&
+		(outOptions->isBenchmark || outOptions->selfPlayGameCount > 0))
+	{
+		return false;
+	}
+	if (outOptions->journalPath != nullptr && outOptions->resumePath != nullptr)
+	{
+		return false;
+	}
+
+	// Analysis only takes the alpha-beta engine's time & thread count; -format only applies to it.
+	if (outOptions->analyzePath != nullptr && (outOptions->isFancy || outOptions->isBenchmark ||
+		outOptions->isAIPlayer[0] || outOptions->isAIPlayer[1] || outOptions->selfPlayGameCount > 0 ||
+		outOptions->recordPath != nullptr || outOptions->journalPath != nullptr ||
+		outOptions->aiEngine != AIEngine::AlphaBeta))
+	{
+		return false;
+	}
+	if (outOptions->hasAnalysisFormat && outOptions->analyzePath == nullptr)
+	{
+		return false;
+	}
+
+	// Only the alpha-beta engine uses a tablebase, and a benchmark measures the search itself.
+	if (outOptions->tablebasePath != nullptr && (outOptions->isBenchmark || outOptions->aiEngine != AIEngine::AlphaBeta))
+	{
+		return false;
+	}
+
+	// Building a tablebase is its own mode, and only takes a board small enough to index and a thread count.
+	if (outOptions->buildTablebasePath != nullptr && (outOptions->isFancy || outOptions->isBenchmark ||
+		outOptions->isAIPlayer[0] || outOptions->isAIPlayer[1] || outOptions->selfPlayGameCount > 0 ||
+		outOptions->recordPath != nullptr || outOptions->journalPath != nullptr || outOptions->resumePath != nullptr ||
+		outOptions->analyzePath != nullptr || outOptions->tablebasePath != nullptr || outOptions->aiEngine != AIEngine::AlphaBeta ||
+		!tictactoe::Tablebase::IsSupported(outOptions->m, outOptions->n, outOptions->k)))
+	{
+		return false;
+	}
+
+	// Analysis and benchmarks are about what the search finds, so they never play from an opening book.
+	if (outOptions->openingBookPath != nullptr && (outOptions->isBenchmark || outOptions->analyzePath != nullptr))
+	{
+		return false;
+	}
+
+	// Building an opening book is its own mode, and needs the records to build it -from.
+	if ((outOptions->buildOpeningBookPath != nullptr) != (outOptions->openingBookRecordPath != nullptr))
+	{
+		return false;
+	}
+	if (outOptions->buildOpeningBookPath != nullptr && (outOptions->isFancy || outOptions->isBenchmark ||
+		outOptions->isAIPlayer[0] || outOptions->isAIPlayer[1] || outOptions->selfPlayGameCount > 0 ||
+		outOptions->recordPath != nullptr || outOptions->journalPath != nullptr || outOptions->resumePath != nullptr ||
+		outOptions->analyzePath != nullptr || outOptions->tablebasePath != nullptr || outOptions->buildTablebasePath != nullptr ||
+		outOptions->openingBookPath != nullptr))
+	{
+		return false;
+	}
+
+	// Unlike alpha-beta, MCTS never finishes on its own, so it needs at least one limit.
+	if (outOptions->aiEngine == AIEngine::MCTS && outOptions->aiPlayoutLimit == 0 && outOptions->aiMoveTimeMs == 0)
+	{
+		return false;
+	}
+
+	return true;
+}
 
 static bool sTryParseUInt(const std::string& str, uint16_t minValue, uint16_t* outValue)
+{
+	uint32_t value;
+	const bool result = sTryParseUInt(str, minValue, UINT16_MAX, &value);
+	*outValue = static_cast<uint16_t>(value);
+	return result;
+}
+
+static bool sTryParseUInt(const std::string& str, uint32_t minValue, uint32_t maxValue, uint32_t* outValue)
 {
 	bool result = false;
 	*outValue = 0;
@@ -101,9 +868,9 @@ static bool sTryParseUInt(const std::string& str, uint16_t minValue, uint16_t* o
 	{
 		size_t pos;
 		auto value = std::stoul(str, &pos);
-		if (value >= minValue && value <= UINT16_MAX && pos == str.length())
+		if (value >= minValue && value <= maxValue && pos == str.length())
 		{
-			*outValue = static_cast<uint16_t>(value);
+			*outValue = static_cast<uint32_t>(value);
 			result = true;
 		}
 	}
@@ -119,13 +886,19 @@ static void sPrintUsage()
 {
 	std::cout << "ConsoleTicTacToe - Created by Eduardo Rodrigues (edrodrigues.com)" << std::endl;
 	std::cout << std::endl;
-	std::cout << "A simple 2-player tic-tac-toe game for the Windows console." << std::endl;
+	std::cout << "A simple 2-player tic-tac-toe game for the Windows console and VT terminals." << std::endl;
 	std::cout << std::endl;
-	std::cout << "usage: ConsoleTicTacToe m n k [-fancy]" << std::endl;
+	std::cout << "usage: ConsoleTicTacToe m n k [-fancy] [-ai <player>] [-time <ms>] [-threads <n>] [-engine <e>] [-playouts <n>] [-bench] [-selfplay <g>] [-policy <p>] [-record <file>] [-journal <file>] [-tablebase <file>] [-book <file>]" << std::endl;
+	std::cout << "       ConsoleTicTacToe m n k -buildtb <file> [-threads <n>]" << std::endl;
+	std::cout << "       ConsoleTicTacToe m n k -buildbook <file> -from <records>" << std::endl;
+	std::cout << "       ConsoleTicTacToe -resume <file> [options]" << std::endl;
+	std::cout << "       ConsoleTicTacToe -analyze <dir> [-format <f>] [-time <ms>] [-threads <n>] [-tablebase <file>]" << std::endl;
+	std::cout << "       ConsoleTicTacToe -export <file>" << std::endl;
 
 	auto printSubItem = [](const char* itemName, const char* itemDesc)
 	{
-		std::cout << "  " << std::left << std::setw(16) << itemName << itemDesc << std::endl;
+		// Names are padded to line up the descriptions, but longer ones still get a space before theirs.
+		std::cout << "  " << std::left << std::setw(15) << itemName << " " << itemDesc << std::endl;
 	};
 
 	std::cout << "Input Arguments:" << std::endl;
@@ -134,6 +907,24 @@ static void sPrintUsage()
 		printSubItem("n", "(n >= 3) The number of rows in the game board.");
 		printSubItem("k", "(k >= 3) The number of marks a player must get in a row to win.");
 		printSubItem("[-fancy]", "(Optional) Indicates the fancier 'graphical' UI should be used.");
+		printSubItem("[-ai <player>]", "(Optional) Makes the given player (1 or 2) computer-controlled. May be repeated.");
+		printSubItem("[-time <ms>]", "(Optional) The time limit for each computer move (default 1000, 0 for no limit).");
+		printSubItem("[-threads <n>]", "(Optional) The number of threads each computer player searches with (default 1).");
+		printSubItem("[-engine <e>]", "(Optional) The computer player's engine: alphabeta (default) or mcts.");
+		printSubItem("[-playouts <n>]", "(Optional) With -engine mcts, searches <n> playouts per move instead of for a fixed time.");
+		printSubItem("[-bench]", "(Optional) Benchmarks the computer player's search with 1 up to <n> threads, then exits.");
+		printSubItem("[-selfplay <g>]", "(Optional) Plays <g> computer-only games on <n> threads, prints the results, then exits.");
+		printSubItem("[-policy <p>]", "(Optional) A self-play player: random (default), greedy or engine. Give twice for players 1 & 2.");
+		printSubItem("[-record <file>]", "(Optional) Appends a binary record of every game played (including self-play) to <file>.");
+		printSubItem("[-journal <file>]", "(Optional) Journals every change to the game to <file> as it's made, so it can be resumed.");
+		printSubItem("-resume <file>", "Resumes the game journaled to <file> (in place of m, n & k), journaling to it again.");
+		printSubItem("-analyze <dir>", "Annotates every recorded game in <dir> with the engine's evaluations, blunders and when it was decided.");
+		printSubItem("[-format <f>]", "(Optional) With -analyze, writes csv (default, a row per move) or json (a line per game).");
+		printSubItem("[-tablebase <file>]", "(Optional) Plays & analyzes positions found in the tablebase <file> perfectly, without searching.");
+		printSubItem("-buildtb <file>", "Solves every position of a board of up to 16 cells on <n> threads, writes the tablebase to <file>, then exits.");
+		printSubItem("[-book <file>]", "(Optional) Computer players play the opening book <file>'s move in any position it has.");
+		printSubItem("-buildbook <file>", "Writes an opening book of the best moves in the recorded games -from <records> to <file>, then exits.");
+		printSubItem("-export <file>", "Prints the games recorded in <file> as text, then exits.");
 	}
 	std::cout << std::endl;
 